@@ -1,23 +1,52 @@
 #include "async_manager.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
-DeviceData AsyncDataManager::getCurrentData()
+// Lock-free but not wait-free: copying buffers[i] only bumps its reference
+// count, and the second load of current, ordered after that increment by the
+// fence, catches a publish that picked buffer i as its target before it saw
+// the reference. A reader retries only when a publish lands between its two
+// loads, which at one publish per acquisition cycle is rare, but nothing
+// bounds the number of retries against a writer publishing back to back.
+std::shared_ptr<const DeviceData> AsyncDataManager::getCurrentData() const
 {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return currentData;
+    for (;;) {
+        uint32_t i = current.load(std::memory_order_acquire);
+        std::shared_ptr<const DeviceData> snapshot = buffers[i];
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (current.load(std::memory_order_acquire) == i) return snapshot;
+    }
 }
 
 AsyncDataManager::AsyncDataManager(OPCUAClient* client, 
-                                  MultimeterDevice* multimeter,
-                                  MachineDevice* machine,
-                                  ComputerDevice* computer,
-                                  int updateIntervalMs)
+                                  const DeviceRegistry* devices,
+                                  int updateIntervalMs,
+                                  AcquisitionMode mode,
+                                  double publishingIntervalMs,
+                                  double samplingIntervalMs)
     : client(client)
-    , multimeter(multimeter)
-    , machine(machine)
-    , computer(computer)
-    , updateIntervalMs(updateIntervalMs) {
-    currentData.lastUpdate = std::chrono::system_clock::now();
+    , devices(devices)
+    , updateIntervalMs(updateIntervalMs)
+    , mode(mode)
+    , publishingIntervalMs(publishingIntervalMs)
+    , samplingIntervalMs(samplingIntervalMs) {
+    for (auto& buffer : buffers) buffer = std::make_shared<DeviceData>();
+    resetData();
+    publishData();
+}
+
+AsyncDataManager::AsyncDataManager(ReplaySource* replay, const DeviceRegistry* devices, int updateIntervalMs)
+    : client(nullptr)
+    , devices(devices)
+    , replay(replay)
+    , updateIntervalMs(updateIntervalMs)
+    , mode(AcquisitionMode::Replay)
+    , publishingIntervalMs(0.0)
+    , samplingIntervalMs(0.0) {
+    for (auto& buffer : buffers) buffer = std::make_shared<DeviceData>();
+    resetData();
+    publishData();
 }
 
 AsyncDataManager::~AsyncDataManager() {
@@ -28,7 +57,15 @@ void AsyncDataManager::start() {
     if (running) return;
     
     running = true;
-    workerThread = std::thread(&AsyncDataManager::workerFunction, this);
+    if (mode == AcquisitionMode::Subscription) {
+        workerThread = std::thread(&AsyncDataManager::subscriptionWorkerFunction, this);
+    } else if (mode == AcquisitionMode::Replay) {
+        workerThread = std::thread(&AsyncDataManager::replayWorkerFunction, this);
+    } else if (mode == AcquisitionMode::PipelinedPolling) {
+        workerThread = std::thread(&AsyncDataManager::pipelinedWorkerFunction, this);
+    } else {
+        workerThread = std::thread(&AsyncDataManager::workerFunction, this);
+    }
     
 #ifdef __MINGW32__
     auto handle = workerThread.native_handle();
@@ -50,25 +87,121 @@ void AsyncDataManager::stop() {
     }
 }
 
+void AsyncDataManager::resetData() {
+    size_t tagCount = devices ? devices->tagCount() : 0;
+    size_t deviceCount = devices ? devices->deviceCount() : 0;
+
+    currentData.values.assign(tagCount, 0.0);
+    currentData.status.assign(tagCount, UA_STATUSCODE_BADWAITINGFORINITIALDATA);
+    currentData.sourceTs.assign(tagCount, 0);
+    currentData.serverTs.assign(tagCount, 0);
+    currentData.clientTs.assign(tagCount, 0);
+    currentData.deviceValid.assign(deviceCount, 0);
+    currentData.markAllDirty();
+    currentData.allValid = false;
+    currentData.lastUpdate = std::chrono::system_clock::now();
+}
+
+void AsyncDataManager::invalidateData(UA_StatusCode status) {
+    for (size_t t = 0; t < currentData.status.size(); t++) {
+        if (currentData.status[t] == status) continue;
+        currentData.status[t] = status;
+        currentData.markDirty(t);
+    }
+    std::fill(currentData.deviceValid.begin(), currentData.deviceValid.end(), 0);
+    currentData.allValid = false;
+    publishChanges();
+}
+
+// Readers keep the snapshot they were handed for as long as they like. The
+// worker writes into a buffer that is neither live nor referenced by any
+// reader, copying only the rows changed since that buffer was last written,
+// then makes it live with a single store. If readers still hold both spare
+// buffers the publish is skipped: dirty keeps accumulating and goes out with
+// the next one.
+void AsyncDataManager::publishData() {
+    DeviceData& d = currentData;
+    const uint32_t live = current.load(std::memory_order_relaxed);
+
+    // Pairs with the fence in getCurrentData: either this sees the reader's
+    // reference or the reader sees that its buffer is no longer live.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t target = SnapshotBuffers;
+    for (uint32_t i = 0; i < SnapshotBuffers; i++) {
+        if (i != live && buffers[i].use_count() == 1) {
+            target = i;
+            break;
+        }
+    }
+    if (target == SnapshotBuffers) return;
+    // use_count() is a relaxed load; the fence orders the last reader's
+    // accesses (released by its decrement) before the writes below.
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    d.sequence++;
+    DeviceData& next = *buffers[target];
+    std::vector<uint64_t>& stale = staleTags[target];
+    if (next.values.size() == d.values.size() && stale.size() == d.dirty.size()) {
+        for (size_t w = 0; w < d.dirty.size(); w++) {
+            for (uint64_t bits = d.dirty[w] | stale[w], t = w * 64; bits; bits >>= 1, t++) {
+                if (!(bits & 1)) continue;
+                next.values[t] = d.values[t];
+                next.status[t] = d.status[t];
+                next.sourceTs[t] = d.sourceTs[t];
+                next.serverTs[t] = d.serverTs[t];
+                next.clientTs[t] = d.clientTs[t];
+            }
+        }
+        next.deviceValid = d.deviceValid;
+        next.dirty = d.dirty;
+        next.sequence = d.sequence;
+        next.allValid = d.allValid;
+        next.lastUpdate = d.lastUpdate;
+    } else {
+        next = d;
+    }
+
+    for (uint32_t i = 0; i < SnapshotBuffers; i++) {
+        if (i == target) {
+            staleTags[i].assign(d.dirty.size(), 0);
+        } else if (staleTags[i].size() != d.dirty.size()) {
+            staleTags[i].assign(d.dirty.size(), ~uint64_t(0));
+        } else {
+            for (size_t w = 0; w < d.dirty.size(); w++) staleTags[i][w] |= d.dirty[w];
+        }
+    }
+
+    current.store(target, std::memory_order_release);
+
+    std::fill(d.dirty.begin(), d.dirty.end(), 0);
+    publishedDeviceValid = d.deviceValid;
+    publishedAllValid = d.allValid;
+    publishedUpdate = d.lastUpdate;
+}
+
+void AsyncDataManager::publishChanges() {
+    const DeviceData& d = currentData;
+    if (d.anyDirty() || d.allValid != publishedAllValid || d.deviceValid != publishedDeviceValid ||
+        d.lastUpdate - publishedUpdate >= heartbeat) {
+        publishData();
+    }
+}
+
 void AsyncDataManager::workerFunction() {
     int connectionErrors = 0;
     const int maxConnectionErrors = 3;
     int readErrors = 0;
     const int maxReadErrors = 5;
     
+    buildReadRequest();
+    
     while (running) {
-        if (!client || !client->isConnected()) {
+        if (!sourceConnected()) {
             connectionErrors++;
             if (connectionErrors >= maxConnectionErrors) {
-                {
-                    std::lock_guard<std::mutex> lock(dataMutex);
-                    currentData.multimeter.valid = false;
-                    currentData.machine.valid = false;
-                    currentData.computer.valid = false;
-                    currentData.allValid = false;
-                }
+                invalidateData();
                 
-                std::this_thread::sleep_for(std::chrono::milliseconds(updateIntervalMs));
+                idleFor(updateIntervalMs);
                 continue;
             }
         } else {
@@ -77,68 +210,8 @@ void AsyncDataManager::workerFunction() {
         
         auto startTime = std::chrono::high_resolution_clock::now();
         
-        DeviceData newData{};
-        newData.lastUpdate = std::chrono::system_clock::now();
-        bool hasValidData = false;
-        
         try {
-            if (multimeter->getDeviceNode().isValid()) {
-                auto values = multimeter->readAllValues(*client);
-                if (!values.empty()) {
-                    newData.multimeter.valid = true;
-                    hasValidData = true;
-                    newData.multimeter.timestamp = std::chrono::system_clock::now();
-                    
-                    if (values.size() > 0 && values[0].first) newData.multimeter.voltage = values[0].second;
-                    if (values.size() > 1 && values[1].first) newData.multimeter.current = values[1].second;
-                    if (values.size() > 2 && values[2].first) newData.multimeter.resistance = values[2].second;
-                    if (values.size() > 3 && values[3].first) newData.multimeter.power = values[3].second;
-                } else {
-                    newData.multimeter.valid = false;
-                }
-            } else {
-                newData.multimeter.valid = false;
-            }
-            
-            if (machine->getDeviceNode().isValid()) {
-                auto values = machine->readAllValues(*client);
-                if (!values.empty()) {
-                    newData.machine.valid = true;
-                    hasValidData = true;
-                    newData.machine.timestamp = std::chrono::system_clock::now();
-                    
-                    if (values.size() > 0 && values[0].first) newData.machine.rpm = values[0].second;
-                    if (values.size() > 1 && values[1].first) newData.machine.power = values[1].second;
-                    if (values.size() > 2 && values[2].first) newData.machine.voltage = values[2].second;
-                    if (values.size() > 3 && values[3].first) newData.machine.energy = values[3].second;
-                } else {
-                    newData.machine.valid = false;
-                }
-            } else {
-                newData.machine.valid = false;
-            }
-            
-            if (computer->getDeviceNode().isValid()) {
-                auto values = computer->readAllValues(*client);
-                if (!values.empty()) {
-                    newData.computer.valid = true;
-                    hasValidData = true;
-                    newData.computer.timestamp = std::chrono::system_clock::now();
-                    
-                    if (values.size() > 0 && values[0].first) newData.computer.fan1 = values[0].second;
-                    if (values.size() > 1 && values[1].first) newData.computer.fan2 = values[1].second;
-                    if (values.size() > 2 && values[2].first) newData.computer.fan3 = values[2].second;
-                    if (values.size() > 3 && values[3].first) newData.computer.cpuLoad = values[3].second;
-                    if (values.size() > 4 && values[4].first) newData.computer.gpuLoad = values[4].second;
-                    if (values.size() > 5 && values[5].first) newData.computer.ramUsage = values[5].second;
-                } else {
-                    newData.computer.valid = false;
-                }
-            } else {
-                newData.computer.valid = false;
-            }
-            
-            newData.allValid = hasValidData;
+            bool hasValidData = pollOnce();
             
             if (hasValidData) {
                 readErrors = 0;
@@ -149,11 +222,6 @@ void AsyncDataManager::workerFunction() {
                 }
             }
             
-            {
-                std::lock_guard<std::mutex> lock(dataMutex);
-                currentData = newData;
-            }
-            
         } catch (const std::exception& e) {
             readErrors++;
             std::cerr << "Ошибка чтения данных: " << e.what() << std::endl;
@@ -162,13 +230,7 @@ void AsyncDataManager::workerFunction() {
                 std::cerr << "Критическая ошибка: невозможно прочитать данные после " << maxReadErrors << " попыток." << std::endl;
             }
             
-            {
-                std::lock_guard<std::mutex> lock(dataMutex);
-                currentData.multimeter.valid = false;
-                currentData.machine.valid = false;
-                currentData.computer.valid = false;
-                currentData.allValid = false;
-            }
+            invalidateData();
         }
         
         auto endTime = std::chrono::high_resolution_clock::now();
@@ -184,10 +246,468 @@ void AsyncDataManager::workerFunction() {
             sleepTime = std::max(sleepTime, 100);
         }
         
-        if (sleepTime > 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        idleFor(std::max(sleepTime, 1));
+    }
+}
+
+bool AsyncDataManager::sourceConnected() const {
+    if (pool) return pool->isConnected();
+    return client && client->isConnected();
+}
+
+void AsyncDataManager::idleFor(int ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+
+    if (!client) {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+
+    while (running) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) break;
+        if (!client->runIterate(static_cast<int>(remaining))) {
+            std::this_thread::sleep_until(deadline);
+            break;
+        }
+    }
+}
+
+TagHistory* AsyncDataManager::registerHistory(size_t row) {
+    const TagTable& tags = devices->getTags();
+    if (tags.historyDepths[row]) history.setCapacity(tags.paths[row], tags.historyDepths[row]);
+    return history.registerTag(tags.paths[row]);
+}
+
+void AsyncDataManager::buildSlots(std::vector<ValueSlot>& slots, std::vector<OPCUANode>& nodes) {
+    slots.clear();
+    nodes.clear();
+    if (!devices) return;
+
+    const TagTable& tags = devices->getTags();
+    for (size_t i = 0; i < tags.size(); i++) {
+        if (!tags.readable[i] || tags.arrays[i] || !tags.nodes[i].isValid()) continue;
+
+        TagHistory* tagHistory = registerHistory(i);
+        uint32_t recordTagId = recorder ? recorder->registerTag(tags.paths[i]) : 0;
+        nodes.push_back(tags.nodes[i]);
+        slots.push_back({this, static_cast<uint32_t>(i), tags.devices[i], tagHistory, recordTagId,
+                         tags.thresholds[i], {}});
+    }
+}
+
+void AsyncDataManager::buildArraySlots() {
+    arraySlots.clear();
+    arrayNodes.clear();
+    if (!devices) return;
+
+    const TagTable& tags = devices->getTags();
+    for (size_t i = 0; i < tags.size(); i++) {
+        if (!tags.readable[i] || !tags.arrays[i] || !tags.nodes[i].isValid()) continue;
+
+        arrayNodes.push_back(tags.nodes[i]);
+        arraySlots.push_back({this, static_cast<uint32_t>(i), tags.devices[i],
+                              history.registerArrayTag(tags.paths[i], arrayHistoryDepth)});
+    }
+}
+
+// Every array sample is a new waveform, so no deadband applies; the row is
+// marked dirty whenever one arrives or the row's status changes.
+void AsyncDataManager::storeArray(const ArraySlot& slot, VariantBuffer&& buffer, int64_t timestampUs) {
+    DeviceData& d = currentData;
+    UA_StatusCode status = buffer.empty() ? UA_STATUSCODE_BADNODATA : UA_STATUSCODE_GOOD;
+
+    if (status == d.status[slot.tag] && UA_StatusCode_isBad(status)) return;
+
+    d.status[slot.tag] = status;
+    d.clientTs[slot.tag] = timestampUs;
+    d.markDirty(slot.tag);
+    if (UA_StatusCode_isBad(status)) return;
+
+    d.deviceValid[slot.device] = 1;
+    d.values[slot.tag] = static_cast<double>(buffer.size());
+    slot.history->append(timestampUs, std::move(buffer), status);
+}
+
+void AsyncDataManager::buildReadRequest() {
+    buildSlots(readSlots, readNodes);
+    buildArraySlots();
+    // Array nodes go in the same request as the scalars, decoded whole.
+    arrayBuffers.resize(arrayNodes.size());
+    if (pool) {
+        pooledRead = pool->prepareRead(readNodes, arrayNodes, UA_TIMESTAMPSTORETURN_BOTH);
+    } else {
+        preparedRead = client ? client->prepareRead(readNodes, arrayNodes, UA_TIMESTAMPSTORETURN_BOTH)
+                              : PreparedRead();
+    }
+    readSamples.assign(readNodes.size(), TagSample());
+}
+
+bool AsyncDataManager::pollOnce() {
+    if (pool) {
+        pool->executeRead(pooledRead, readSamples.data(), readSamples.size(), arrayBuffers.data(), arrayBuffers.size());
+        return applyReadResults(readSamples.data(), readSamples.size(), arrayBuffers.data(), arrayBuffers.size(),
+                                std::chrono::system_clock::now());
+    }
+
+    if (!client || preparedRead.empty()) {
+        return applyReadResults(nullptr, 0, nullptr, 0, std::chrono::system_clock::now());
+    }
+
+    client->executeRead(preparedRead, readSamples.data(), readSamples.size(), arrayBuffers.data(), arrayBuffers.size());
+    return applyReadResults(readSamples.data(), readSamples.size(), arrayBuffers.data(), arrayBuffers.size(),
+                            std::chrono::system_clock::now());
+}
+
+// A sample with the same status as the stored one is dropped unless its value
+// moved by more than the tag's deadband from the last value passed on, which
+// is how a server applies a DataChangeFilter, so polling and subscriptions
+// yield the same stream. History and recordings are stamped with the source
+// timestamp when the server provides one.
+void AsyncDataManager::storeSample(const ValueSlot& slot, const TagSample& sample, int64_t clientUs) {
+    DeviceData& d = currentData;
+    bool bad = UA_StatusCode_isBad(sample.status);
+    if (!bad) d.deviceValid[slot.device] = 1;
+
+    if (sample.status == d.status[slot.tag] &&
+        (bad || std::fabs(sample.value - d.values[slot.tag]) <= slot.threshold)) {
+        return;
+    }
+
+    d.status[slot.tag] = sample.status;
+    d.sourceTs[slot.tag] = sample.sourceTs;
+    d.serverTs[slot.tag] = sample.serverTs;
+    d.clientTs[slot.tag] = clientUs;
+    d.markDirty(slot.tag);
+    if (bad) return;
+
+    d.values[slot.tag] = sample.value;
+
+    int64_t timestampUs = sample.sourceTs ? sample.sourceTs : clientUs;
+    slot.history->append(timestampUs, sample.value, sample.status);
+    if (recorder) recorder->record(slot.recordTagId, timestampUs, sample.value, sample.status);
+}
+
+bool AsyncDataManager::applyReadResults(const TagSample* samples, size_t count,
+                                        VariantBuffer* arrays, size_t arrayCount,
+                                        std::chrono::system_clock::time_point sampleTime) {
+    DeviceData& d = currentData;
+    std::fill(d.deviceValid.begin(), d.deviceValid.end(), 0);
+    d.lastUpdate = sampleTime;
+
+    int64_t sampleUs = std::chrono::duration_cast<std::chrono::microseconds>(sampleTime.time_since_epoch()).count();
+    bool hasValidData = false;
+
+    for (size_t i = 0; i < count && i < readSlots.size(); i++) {
+        storeSample(readSlots[i], samples[i], sampleUs);
+        hasValidData = hasValidData || !UA_StatusCode_isBad(samples[i].status);
+    }
+
+    for (size_t i = 0; i < arrayCount && i < arraySlots.size(); i++) {
+        hasValidData = hasValidData || !arrays[i].empty();
+        storeArray(arraySlots[i], std::move(arrays[i]), sampleUs);
+    }
+
+    d.allValid = hasValidData;
+    publishChanges();
+
+    return hasValidData;
+}
+
+void AsyncDataManager::pipelinedWorkerFunction() {
+    buildReadRequest();
+    if (!client) return;
+
+    auto state = std::make_shared<PipelineState>();
+    state->prepared = std::move(preparedRead);
+    client->setMaxInFlight(std::max(client->getMaxInFlight(), pipelineDepth));
+
+    const auto tick = std::chrono::milliseconds(std::max(updateIntervalMs, 1));
+    const auto lateAfter = tick * static_cast<int>(pipelineDepth);
+    auto next = std::chrono::steady_clock::now();
+    uint64_t sequence = 0;
+
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (now >= next) {
+            next += tick;
+            if (now >= next) {
+                auto missed = (now - next) / tick + 1;
+                pipelineDropped.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+                next += tick * missed;
+            }
+
+            if (!client->isConnected() || state->prepared.empty()) {
+                invalidateData();
+                pipelineDropped.fetch_add(1, std::memory_order_relaxed);
+            } else if (state->outstanding >= pipelineDepth) {
+                pipelineDropped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                uint64_t seq = ++sequence;
+                bool queued = client->readAsync(state->prepared, [this, state, seq, lateAfter](AsyncReadResult& r) {
+                    if (!state->active) return;
+                    state->outstanding--;
+
+                    if (r.status != UA_STATUSCODE_GOOD) {
+                        pipelineFailed.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+
+                    auto rtt = r.completed - r.issued;
+                    pipelineLastRttUs.store(std::chrono::duration_cast<std::chrono::microseconds>(rtt).count(),
+                                            std::memory_order_relaxed);
+
+                    if (seq < state->newestApplied) {
+                        pipelineLate.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    if (rtt > lateAfter) {
+                        pipelineLate.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    state->newestApplied = seq;
+                    pipelineCompleted.fetch_add(1, std::memory_order_relaxed);
+
+                    auto sampleTime = std::chrono::system_clock::now() -
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::steady_clock::now() - r.issued);
+                    applyReadResults(r.samples.data(), r.samples.size(), r.arrays.data(), r.arrays.size(),
+                                     sampleTime);
+                });
+
+                if (queued) {
+                    state->outstanding++;
+                    pipelineIssued.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    pipelineDropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            next - std::chrono::steady_clock::now()).count();
+        if (!client->runIterate(static_cast<int>(std::max<int64_t>(remaining, 0)))) {
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (state->outstanding > 0 && std::chrono::steady_clock::now() < drainDeadline) {
+        if (!client->runIterate(10)) break;
+    }
+    state->active = false;
+}
+
+AsyncDataManager::PipelineStats AsyncDataManager::getPipelineStats() const {
+    PipelineStats stats;
+    stats.issued = pipelineIssued.load(std::memory_order_relaxed);
+    stats.completed = pipelineCompleted.load(std::memory_order_relaxed);
+    stats.dropped = pipelineDropped.load(std::memory_order_relaxed);
+    stats.late = pipelineLate.load(std::memory_order_relaxed);
+    stats.failed = pipelineFailed.load(std::memory_order_relaxed);
+    stats.lastRttMs = pipelineLastRttUs.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+UA_UInt32 AsyncDataManager::setupSubscription() {
+    UA_UInt32 subscriptionId = client->createSubscription(publishingIntervalMs, this);
+    if (subscriptionId == 0) return 0;
+
+    std::vector<void*> contexts;
+    std::vector<UA_DataChangeFilter> filters(monitoredSlots.size());
+    contexts.reserve(monitoredSlots.size());
+    for (size_t i = 0; i < monitoredSlots.size(); i++) {
+        ValueSlot& slot = monitoredSlots[i];
+        const TagTable& tags = devices->getTags();
+        contexts.push_back(&slot);
+        filters[i].trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+        filters[i].deadbandType = tags.deadbandTypes[slot.tag];
+        filters[i].deadbandValue = tags.deadbands[slot.tag];
+    }
+
+    auto itemIds = client->addMonitoredItems(subscriptionId, monitoredNodes, samplingIntervalMs,
+                                             &AsyncDataManager::dataChangeCallback, contexts, filters);
+
+    size_t created = 0;
+    for (auto id : itemIds) {
+        if (id != 0) created++;
+    }
+
+    if (!arrayNodes.empty()) {
+        std::vector<void*> arrayContexts;
+        for (ArraySlot& slot : arraySlots) arrayContexts.push_back(&slot);
+        for (auto id : client->addMonitoredItems(subscriptionId, arrayNodes, samplingIntervalMs,
+                                                 &AsyncDataManager::arrayChangeCallback, arrayContexts)) {
+            if (id != 0) created++;
+        }
+    }
+
+    if (created == 0) {
+        std::cerr << "Не удалось создать ни одного элемента мониторинга" << std::endl;
+        client->deleteSubscription(subscriptionId);
+        return 0;
+    }
+
+    return subscriptionId;
+}
+
+void AsyncDataManager::dataChangeCallback(UA_Client* client, UA_UInt32 subId, void* subContext,
+                                          UA_UInt32 monId, void* monContext, UA_DataValue* value) {
+    auto* slot = static_cast<ValueSlot*>(monContext);
+    if (!slot || !value) return;
+
+    AsyncDataManager* self = slot->manager;
+    auto now = std::chrono::system_clock::now();
+    int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+
+    TagSample sample;
+    sample.value = self->currentData.values[slot->tag];
+    bool usable = decodeSample(*value, slot->decoder, sample);
+    self->storeSample(*slot, sample, nowUs);
+
+    if (usable) self->currentData.allValid = true;
+    self->currentData.lastUpdate = now;
+    self->notificationsPending = true;
+}
+
+// The stack clears the notification after the callback returns, so the
+// array is copied out rather than adopted.
+void AsyncDataManager::arrayChangeCallback(UA_Client* client, UA_UInt32 subId, void* subContext,
+                                           UA_UInt32 monId, void* monContext, UA_DataValue* value) {
+    auto* slot = static_cast<ArraySlot*>(monContext);
+    if (!slot || !value) return;
+
+    AsyncDataManager* self = slot->manager;
+    auto now = std::chrono::system_clock::now();
+    int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+
+    VariantBuffer buffer;
+    UA_Variant copy;
+    UA_Variant_init(&copy);
+    if (value->hasValue && (!value->hasStatus || !UA_StatusCode_isBad(value->status)) &&
+        UA_Variant_copy(&value->value, &copy) == UA_STATUSCODE_GOOD) {
+        buffer.adopt(copy);
+    }
+
+    int64_t timestampUs = value->hasSourceTimestamp
+        ? (value->sourceTimestamp - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC : nowUs;
+    self->storeArray(*slot, std::move(buffer), timestampUs);
+    self->currentData.lastUpdate = now;
+    self->notificationsPending = true;
+}
+
+void AsyncDataManager::subscriptionWorkerFunction() {
+    UA_UInt32 subscriptionId = 0;
+    uint64_t sessionGeneration = 0;
+
+    buildSlots(monitoredSlots, monitoredNodes);
+    buildArraySlots();
+    if (monitoredNodes.empty() && arrayNodes.empty()) {
+        std::cerr << "Нет узлов для подписки" << std::endl;
+    }
+
+    while (running) {
+        if (!client || !client->isConnected()) {
+            subscriptionId = 0;
+            invalidateData();
+            idleFor(std::max(updateIntervalMs, 100));
+            continue;
+        }
+
+        if (subscriptionId != 0 && client->getSessionGeneration() != sessionGeneration) {
+            client->deleteSubscription(subscriptionId);
+            subscriptionId = 0;
+        }
+
+        if (subscriptionId == 0) {
+            sessionGeneration = client->getSessionGeneration();
+            subscriptionId = setupSubscription();
+            if (subscriptionId == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::max(updateIntervalMs, 100)));
+                continue;
+            }
+        }
+
+        if (!client->runIterate(updateIntervalMs)) {
+            std::cerr << "Потеряна связь при получении уведомлений подписки" << std::endl;
+            client->deleteSubscription(subscriptionId);
+            subscriptionId = 0;
+            notificationsPending = false;
+            invalidateData();
+        } else if (notificationsPending) {
+            notificationsPending = false;
+            publishChanges();
+        }
+    }
+
+    if (client && subscriptionId != 0) {
+        client->deleteSubscription(subscriptionId);
+    }
+}
+
+void AsyncDataManager::buildReplaySlots() {
+    replaySlots.clear();
+
+    for (const auto& tag : replay->getTagNames()) {
+        size_t row = devices ? devices->findTag(tag) : DeviceRegistry::npos;
+        if (row == DeviceRegistry::npos) {
+            replaySlots.push_back({this, UINT32_MAX, 0, nullptr, 0, 0.0, {}});
+            continue;
+        }
+
+        uint32_t device = devices->getTags().devices[row];
+        replaySlots.push_back({this, static_cast<uint32_t>(row), device, registerHistory(row), 0, 0.0, {}});
+    }
+}
+
+void AsyncDataManager::replayWorkerFunction() {
+    if (!replay) return;
+
+    buildReplaySlots();
+    replay->rewind(std::chrono::steady_clock::now());
+
+    const size_t maxBatch = 4096;
+
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        auto wallNow = std::chrono::system_clock::now();
+        int64_t wallNowUs = std::chrono::duration_cast<std::chrono::microseconds>(wallNow.time_since_epoch()).count();
+
+        size_t applied = replay->advance(now, maxBatch, [&](const SampleRecord& rec) {
+            if (rec.tagId >= replaySlots.size()) return;
+            const ValueSlot& slot = replaySlots[rec.tagId];
+            if (!slot.history) return;
+
+            currentData.status[slot.tag] = rec.quality;
+            currentData.sourceTs[slot.tag] = rec.timestampUs;
+            currentData.clientTs[slot.tag] = wallNowUs;
+            currentData.markDirty(slot.tag);
+            if (UA_StatusCode_isBad(rec.quality)) return;
+
+            currentData.values[slot.tag] = rec.value;
+            currentData.deviceValid[slot.device] = 1;
+            slot.history->append(rec.timestampUs, rec.value, rec.quality);
+        });
+
+        if (applied > 0) {
+            currentData.allValid = true;
+            currentData.lastUpdate = wallNow;
+            publishData();
+        }
+
+        if (replay->finished()) {
+            if (replay->isLooping()) {
+                replay->rewind(now);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::max(updateIntervalMs, 1)));
+                continue;
+            }
+        }
+
+        if (replay->getSpeed() > 0.0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::max(updateIntervalMs, 1)));
         }
     }
 }
\ No newline at end of file
@@ -2,47 +2,77 @@
 #define ASYNC_MANAGER_H
 
 #include "opcua_client.h"
+#include "client_pool.h"
 #include "device_managers.h"
+#include "tag_history.h"
+#include "recorder.h"
+#include "replay_source.h"
 #include <vector>
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <memory>
 
+// Struct-of-arrays tag store in TagTable row order, updated in place by the
+// acquisition worker. status is the OPC UA StatusCode of the last sample; on a
+// Bad sample values keeps the last good value. Timestamps are microseconds
+// since the Unix epoch: sourceTs/serverTs as sent by the server (0 if not),
+// clientTs when the sample reached this process. deviceValid is indexed by
+// Device::getIndex() and set when any tag of the device was usable in the
+// last cycle. Array rows carry their element count in values; the elements
+// themselves are in the row's ArrayHistory.
+//
+// Snapshots are published when some tag changed, when allValid or a
+// deviceValid flag changed, and otherwise at least once per heartbeat interval
+// of successful acquisition, so lastUpdate never looks staler than that while
+// samples keep arriving. dirty has a bit per tag
+// row whose value or status differs from the snapshot numbered sequence - 1;
+// a reader that did not see that one must treat every tag as changed.
 struct DeviceData
 {
-    struct MultimeterData {
-        bool valid{false};
-        double voltage{};
-        double current{};
-        double resistance{};
-        double power{};
-        std::chrono::system_clock::time_point timestamp;
-    } multimeter;
-
-    struct MachineData {
-        bool valid{false};
-        double rpm{};
-        double power{};
-        double voltage{};
-        double energy{};
-        std::chrono::system_clock::time_point timestamp;
-    } machine;
-
-    struct ComputerData {
-        bool valid{false};
-        double fan1{};
-        double fan2{};
-        double fan3{};
-        double cpuLoad{};
-        double gpuLoad{};
-        double ramUsage{};
-        std::chrono::system_clock::time_point timestamp;
-    } computer;
+    std::vector<double> values;
+    std::vector<UA_StatusCode> status;
+    std::vector<int64_t> sourceTs;
+    std::vector<int64_t> serverTs;
+    std::vector<int64_t> clientTs;
+    std::vector<uint8_t> deviceValid;
+    std::vector<uint64_t> dirty;
+    uint64_t sequence{0};
 
     bool allValid{false};
     std::chrono::system_clock::time_point lastUpdate;
+
+    bool isUsable(size_t tag) const { return !UA_StatusCode_isBad(status[tag]); }
+
+    bool isDirty(size_t tag) const { return (dirty[tag / 64] >> (tag % 64)) & 1; }
+    void markDirty(size_t tag) { dirty[tag / 64] |= uint64_t(1) << (tag % 64); }
+    bool anyDirty() const {
+        return std::any_of(dirty.begin(), dirty.end(), [](uint64_t w) { return w != 0; });
+    }
+    void markAllDirty() {
+        dirty.assign((values.size() + 63) / 64, ~uint64_t(0));
+        if (values.size() % 64) dirty.back() = (uint64_t(1) << (values.size() % 64)) - 1;
+    }
+
+    template<typename F>
+    void forEachDirty(F&& f) const {
+        for (size_t w = 0; w < dirty.size(); w++) {
+            for (uint64_t bits = dirty[w], t = w * 64; bits; bits >>= 1, t++) {
+                if (bits & 1) f(static_cast<size_t>(t));
+            }
+        }
+    }
+};
+
+
+enum class AcquisitionMode {
+    Polling,
+    Subscription,
+    Replay,
+    PipelinedPolling
 };
 
 
@@ -50,33 +80,150 @@ class AsyncDataManager {
 private:
     std::atomic<bool> running{false};
     std::thread workerThread;
-    std::mutex dataMutex;
     std::condition_variable dataCV;
     
+    // Triple buffer of published snapshots: current indexes the live one,
+    // staleTags[i] marks the rows changed since buffers[i] was last written.
+    static constexpr uint32_t SnapshotBuffers = 3;
     DeviceData currentData;
+    std::shared_ptr<DeviceData> buffers[SnapshotBuffers];
+    std::vector<uint64_t> staleTags[SnapshotBuffers];
+    std::atomic<uint32_t> current{0};
+    // Schema-loaded and discovered tags can number in the thousands, so unless
+    // a tag asks for more it keeps a short history (about 5 KB).
+    static constexpr size_t DefaultHistoryDepth = 256;
+    HistoryStore history{DefaultHistoryDepth};
+    Recorder* recorder{nullptr};
+    bool notificationsPending{false};
+    std::vector<uint8_t> publishedDeviceValid;
+    bool publishedAllValid{false};
+    std::chrono::system_clock::time_point publishedUpdate;
+    std::chrono::milliseconds heartbeat{1000};
     OPCUAClient* client;
-    MultimeterDevice* multimeter;
-    MachineDevice* machine;
-    ComputerDevice* computer;
+    const DeviceRegistry* devices;
+    ReplaySource* replay{nullptr};
     
     int updateIntervalMs;
 
+    AcquisitionMode mode;
+    double publishingIntervalMs;
+    double samplingIntervalMs;
+
+    struct ValueSlot {
+        AsyncDataManager* manager;
+        uint32_t tag;
+        uint32_t device;
+        TagHistory* history;
+        uint32_t recordTagId;
+        double threshold;
+        CachedDecoder<double> decoder;
+    };
+    std::vector<ValueSlot> monitoredSlots;
+    std::vector<OPCUANode> monitoredNodes;
+
+    std::vector<ValueSlot> readSlots;
+    std::vector<OPCUANode> readNodes;
+    PreparedRead preparedRead;
+    OPCUAClientPool* pool{nullptr};
+    PartitionedRead pooledRead;
+    std::vector<TagSample> readSamples;
+
+    std::vector<ValueSlot> replaySlots;
+
+    struct ArraySlot {
+        AsyncDataManager* manager;
+        uint32_t tag;
+        uint32_t device;
+        ArrayHistory* history;
+    };
+    size_t arrayHistoryDepth{64};
+    std::vector<ArraySlot> arraySlots;
+    std::vector<OPCUANode> arrayNodes;
+    std::vector<VariantBuffer> arrayBuffers;
+
+    struct PipelineState {
+        std::atomic<bool> active{true};
+        size_t outstanding{0};
+        uint64_t newestApplied{0};
+        PreparedRead prepared;
+    };
+    size_t pipelineDepth{4};
+    std::atomic<uint64_t> pipelineIssued{0};
+    std::atomic<uint64_t> pipelineCompleted{0};
+    std::atomic<uint64_t> pipelineDropped{0};
+    std::atomic<uint64_t> pipelineLate{0};
+    std::atomic<uint64_t> pipelineFailed{0};
+    std::atomic<int64_t> pipelineLastRttUs{0};
+
     void workerFunction();
+    void subscriptionWorkerFunction();
+    void replayWorkerFunction();
+    void idleFor(int ms);
+    void buildReplaySlots();
+    TagHistory* registerHistory(size_t row);
+    void buildSlots(std::vector<ValueSlot>& slots, std::vector<OPCUANode>& nodes);
+    void buildArraySlots();
+    void storeArray(const ArraySlot& slot, VariantBuffer&& buffer, int64_t timestampUs);
+    void buildReadRequest();
+    bool pollOnce();
+    bool sourceConnected() const;
+    bool applyReadResults(const TagSample* samples, size_t count, VariantBuffer* arrays, size_t arrayCount,
+                          std::chrono::system_clock::time_point sampleTime);
+    void storeSample(const ValueSlot& slot, const TagSample& sample, int64_t clientUs);
+    void pipelinedWorkerFunction();
+    UA_UInt32 setupSubscription();
+    void resetData();
+    void invalidateData(UA_StatusCode status = UA_STATUSCODE_BADNOTCONNECTED);
+    void publishData();
+    void publishChanges();
+
+    static void dataChangeCallback(UA_Client* client, UA_UInt32 subId, void* subContext,
+                                   UA_UInt32 monId, void* monContext, UA_DataValue* value);
+    static void arrayChangeCallback(UA_Client* client, UA_UInt32 subId, void* subContext,
+                                    UA_UInt32 monId, void* monContext, UA_DataValue* value);
 
 public:
+    struct PipelineStats {
+        uint64_t issued{0};
+        uint64_t completed{0};
+        uint64_t dropped{0};
+        uint64_t late{0};
+        uint64_t failed{0};
+        double lastRttMs{0.0};
+    };
+
     AsyncDataManager(OPCUAClient* client, 
-                    MultimeterDevice* multimeter,
-                    MachineDevice* machine,
-                    ComputerDevice* computer,
-                    int updateIntervalMs = 50);
+                    const DeviceRegistry* devices,
+                    int updateIntervalMs = 50,
+                    AcquisitionMode mode = AcquisitionMode::Polling,
+                    double publishingIntervalMs = 100.0,
+                    double samplingIntervalMs = 50.0);
+
+    AsyncDataManager(ReplaySource* replay, const DeviceRegistry* devices, int updateIntervalMs = 50);
     
     ~AsyncDataManager();
     
     void start();
     void stop();
-    DeviceData getCurrentData();
+    std::shared_ptr<const DeviceData> getCurrentData() const;
+    const DeviceRegistry* getDevices() const { return devices; }
     bool isRunning() const { return running; }
     void setUpdateInterval(int ms) { updateIntervalMs = ms; }
+    AcquisitionMode getMode() const { return mode; }
+    double getPublishingInterval() const { return publishingIntervalMs; }
+    double getSamplingInterval() const { return samplingIntervalMs; }
+
+    HistoryStore& getHistory() { return history; }
+    const HistoryStore& getHistory() const { return history; }
+    void setRecorder(Recorder* r) { recorder = r; }
+    void setHeartbeat(std::chrono::milliseconds interval) { heartbeat = interval; }
+    void setArrayHistoryDepth(size_t snapshots) { arrayHistoryDepth = std::max<size_t>(snapshots, 1); }
+
+    void setClientPool(OPCUAClientPool* p) { pool = p; }
+
+    void setPipelineDepth(size_t depth) { pipelineDepth = std::max<size_t>(depth, 1); }
+    size_t getPipelineDepth() const { return pipelineDepth; }
+    PipelineStats getPipelineStats() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+
+struct BackoffPolicy {
+    std::chrono::milliseconds initialDelay{250};
+    std::chrono::milliseconds maxDelay{30000};
+    double multiplier{2.0};
+    double jitter{0.2};
+};
+
+
+// Jitter spreads the retries of many clients that lost the same server at
+// the same moment.
+class ExponentialBackoff {
+private:
+    BackoffPolicy policy;
+    uint32_t attempts{0};
+    std::minstd_rand rng;
+
+public:
+    explicit ExponentialBackoff(const BackoffPolicy& policy = BackoffPolicy())
+        : policy(policy), rng(std::random_device{}()) {}
+
+    std::chrono::milliseconds next() {
+        double base = policy.initialDelay.count() * std::pow(policy.multiplier, attempts);
+        base = std::min(base, static_cast<double>(policy.maxDelay.count()));
+        if (attempts < 64) attempts++;
+
+        std::uniform_real_distribution<double> spread(-policy.jitter, policy.jitter);
+        double delay = std::clamp(base * (1.0 + spread(rng)), 1.0, static_cast<double>(policy.maxDelay.count()));
+        return std::chrono::milliseconds(static_cast<int64_t>(delay));
+    }
+
+    void reset() { attempts = 0; }
+    uint32_t attemptCount() const { return attempts; }
+    const BackoffPolicy& getPolicy() const { return policy; }
+};
+
+#endif
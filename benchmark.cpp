@@ -0,0 +1,978 @@
+#include "opcua_client.h"
+#include "client_pool.h"
+#include "server_registry.h"
+#include "device_managers.h"
+#include "async_manager.h"
+#include "seqlock.h"
+#include "tag_history.h"
+#include "sim_server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+namespace {
+    std::atomic<size_t> g_allocations{0};
+
+    struct BenchResult {
+        size_t iterations{};
+        double microsPerCall{};
+        double allocationsPerCall{};
+    };
+
+    template<typename Fn>
+    BenchResult measure(size_t iterations, Fn&& fn) {
+        for (size_t i = 0; i < iterations / 10 + 1; i++) {
+            fn();
+        }
+
+        size_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++) {
+            fn();
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        size_t allocationsAfter = g_allocations.load(std::memory_order_relaxed);
+
+        BenchResult result;
+        result.iterations = iterations;
+        result.microsPerCall = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+        result.allocationsPerCall = static_cast<double>(allocationsAfter - allocationsBefore) / iterations;
+        return result;
+    }
+
+    void printResult(const std::string& name, const BenchResult& r) {
+        std::cout << std::left << std::setw(28) << name
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.microsPerCall << " us/call"
+                  << std::setw(10) << r.allocationsPerCall << " allocs/call"
+                  << "  (" << r.iterations << " iterations)" << std::endl;
+    }
+
+    int benchRead(const std::string& endpoint, size_t iterations) {
+        OPCUAClient client(endpoint);
+        if (!client.connect()) {
+            std::cerr << "Failed to connect to " << endpoint << std::endl;
+            return 1;
+        }
+
+        OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+        DeviceRegistry registry;
+        registry.prefetch(client, objectsFolder);
+        registry.resolve(client, objectsFolder, "");
+
+        std::vector<OPCUANode> nodes = registry.readableNodes();
+
+        if (nodes.empty()) {
+            std::cerr << "No device nodes found on " << endpoint << std::endl;
+            return 1;
+        }
+
+        std::cout << "Reading " << nodes.size() << " nodes from " << endpoint
+                  << " (discovered with " << client.browseRequestCount() << " browse requests)" << std::endl;
+
+        PreparedRead prepared = client.prepareRead(nodes);
+        std::vector<std::pair<bool, double>> values(nodes.size());
+
+        auto preparedResult = measure(iterations, [&]() {
+            client.executeRead(prepared, values.data(), values.size());
+        });
+
+        auto multipleResult = measure(iterations, [&]() {
+            auto v = client.readMultipleValues(nodes);
+            (void)v;
+        });
+
+        printResult("executeRead (prepared)", preparedResult);
+        printResult("readMultipleValues", multipleResult);
+
+        client.disconnect();
+        return preparedResult.allocationsPerCall == 0.0 ? 0 : 2;
+    }
+
+    struct LatencyStats {
+        double p50{};
+        double p99{};
+        double max{};
+    };
+
+    LatencyStats latencyStats(std::vector<double>& samples) {
+        LatencyStats stats;
+        if (samples.empty()) return stats;
+        std::sort(samples.begin(), samples.end());
+        stats.p50 = samples[samples.size() / 2];
+        stats.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        stats.max = samples.back();
+        return stats;
+    }
+
+    // Same shape as the fixed three-device snapshot the seqlock was written for:
+    // every readable builtin tag and a timestamp per device.
+    struct SnapshotSample {
+        double values[BuiltinTags::ReadableCount];
+        std::chrono::system_clock::time_point timestamps[BUILTIN_DEVICE_COUNT];
+        std::chrono::system_clock::time_point lastUpdate;
+    };
+
+    void fillSnapshot(SnapshotSample& d, uint64_t k) {
+        double v = static_cast<double>(k);
+        auto ts = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(k));
+        for (double& x : d.values) x = v;
+        for (auto& t : d.timestamps) t = ts;
+        d.lastUpdate = ts;
+    }
+
+    bool isConsistent(const SnapshotSample& d) {
+        const double v = d.values[0];
+        for (double x : d.values) {
+            if (x != v) return false;
+        }
+        auto ts = std::chrono::system_clock::duration(static_cast<uint64_t>(v));
+        if (d.lastUpdate.time_since_epoch() != ts) return false;
+        for (const auto& t : d.timestamps) {
+            if (t != d.lastUpdate) return false;
+        }
+        return true;
+    }
+
+    int benchSeqlock(int readerCount, int durationMs) {
+        const size_t maxSamples = 1 << 20;
+        SeqLock<SnapshotSample> snapshot;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> tornSnapshots{0};
+
+        std::vector<double> writerSamples;
+        writerSamples.reserve(maxSamples);
+        std::vector<std::vector<double>> readerSamples(readerCount);
+        std::vector<uint64_t> readerOps(readerCount, 0);
+        uint64_t writerOps = 0;
+
+        std::thread writer([&]() {
+            SnapshotSample d{};
+            for (uint64_t k = 1; !stop.load(std::memory_order_relaxed); k++) {
+                fillSnapshot(d, k);
+                auto t0 = std::chrono::steady_clock::now();
+                snapshot.store(d);
+                auto t1 = std::chrono::steady_clock::now();
+                if (writerSamples.size() < maxSamples) {
+                    writerSamples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+                }
+                writerOps++;
+            }
+        });
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; r++) {
+            readerSamples[r].reserve(maxSamples);
+            readers.emplace_back([&, r]() {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    SnapshotSample d = snapshot.load();
+                    auto t1 = std::chrono::steady_clock::now();
+                    if (!isConsistent(d)) {
+                        tornSnapshots.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (readerSamples[r].size() < maxSamples) {
+                        readerSamples[r].push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+                    }
+                    readerOps[r]++;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+        stop = true;
+        writer.join();
+        for (auto& t : readers) t.join();
+
+        std::vector<double> allReaderSamples;
+        uint64_t totalReads = 0;
+        for (int r = 0; r < readerCount; r++) {
+            allReaderSamples.insert(allReaderSamples.end(), readerSamples[r].begin(), readerSamples[r].end());
+            totalReads += readerOps[r];
+        }
+
+        auto w = latencyStats(writerSamples);
+        auto rd = latencyStats(allReaderSamples);
+        double seconds = durationMs / 1000.0;
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "SeqLock<SnapshotSample> (" << sizeof(SnapshotSample) << " bytes), "
+                  << readerCount << " readers, " << durationMs << " ms" << std::endl
+                  << "  writes: " << writerOps / seconds << "/s  p50 " << w.p50 << " ns  p99 " << w.p99
+                  << " ns  max " << w.max << " ns" << std::endl
+                  << "  reads:  " << totalReads / seconds << "/s  p50 " << rd.p50 << " ns  p99 " << rd.p99
+                  << " ns  max " << rd.max << " ns" << std::endl
+                  << "  torn snapshots: " << tornSnapshots.load() << std::endl;
+
+        return tornSnapshots.load() == 0 ? 0 : 2;
+    }
+
+    int benchHistory(int tagCount, int aggregateRateHz, int durationMs) {
+        HistoryStore store(8192);
+        std::vector<TagHistory*> tags;
+        for (int i = 0; i < tagCount; i++) {
+            tags.push_back(store.registerTag("Bench/Tag" + std::to_string(i)));
+        }
+
+        const uint64_t unpacedAppends = 10000000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < unpacedAppends; i++) {
+            tags[i % tags.size()]->append(static_cast<int64_t>(i), static_cast<double>(i));
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double unpacedNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / unpacedAppends;
+
+        std::atomic<bool> stop{false};
+        std::vector<double> appendSamples;
+        appendSamples.reserve(static_cast<size_t>(aggregateRateHz) * (durationMs / 1000 + 1));
+        uint64_t appended = 0;
+
+        std::thread writer([&]() {
+            const auto tick = std::chrono::milliseconds(1);
+            const int perTick = std::max(1, aggregateRateHz / 1000);
+            auto next = std::chrono::steady_clock::now();
+            size_t tag = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                for (int i = 0; i < perTick; i++) {
+                    auto a0 = std::chrono::steady_clock::now();
+                    tags[tag]->append(nowUs, static_cast<double>(appended));
+                    auto a1 = std::chrono::steady_clock::now();
+                    appendSamples.push_back(std::chrono::duration<double, std::nano>(a1 - a0).count());
+                    tag = (tag + 1) % tags.size();
+                    appended++;
+                }
+                next += tick;
+                std::this_thread::sleep_until(next);
+            }
+        });
+
+        std::vector<double> readSamples;
+        std::vector<HistorySample> buffer(1024);
+        uint64_t samplesRead = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(durationMs);
+        size_t tag = 0;
+        while (std::chrono::steady_clock::now() < deadline) {
+            int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            auto r0 = std::chrono::steady_clock::now();
+            samplesRead += tags[tag]->readLast(256, buffer.data());
+            samplesRead += tags[tag]->readRange(nowUs - 500000, nowUs, buffer.data(), buffer.size());
+            auto r1 = std::chrono::steady_clock::now();
+            readSamples.push_back(std::chrono::duration<double, std::nano>(r1 - r0).count());
+            tag = (tag + 1) % tags.size();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        stop = true;
+        writer.join();
+
+        auto a = latencyStats(appendSamples);
+        auto rd = latencyStats(readSamples);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "TagHistory: " << tagCount << " tags, " << aggregateRateHz << " samples/s aggregate, "
+                  << store.memoryUsage() / 1024 << " KiB" << std::endl
+                  << "  unpaced append: " << unpacedNs << " ns/sample" << std::endl
+                  << "  paced append:   " << appended << " samples  p50 " << a.p50 << " ns  p99 " << a.p99
+                  << " ns  max " << a.max << " ns" << std::endl
+                  << "  readLast(256)+readRange(500ms): p50 " << rd.p50 << " ns  p99 " << rd.p99
+                  << " ns  (" << samplesRead << " samples read)" << std::endl;
+        return 0;
+    }
+
+    // Acquisition runs on the manager's worker and, when pooled, on the
+    // session threads, so every mode is charged with process time. With an
+    // in-process simulation server that includes the server too.
+    double processCpuSeconds() {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+        auto toSeconds = [](const FILETIME& ft) {
+            return ((static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 1e7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+    }
+
+    size_t residentKiB() {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        size_t totalPages = 0, residentPages = 0;
+        statm >> totalPages >> residentPages;
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    double wallClockSeconds() {
+        return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Load tags hold the server wall clock, so age = observation time - value.
+    struct AgeRecorder {
+        std::vector<double> agesMs;
+        uint64_t values{0};
+        bool recording{false};
+
+        void add(double value, double nowSeconds) {
+            if (!recording) return;
+            values++;
+            if (agesMs.size() < agesMs.capacity()) {
+                agesMs.push_back((nowSeconds - value) * 1000.0);
+            }
+        }
+    };
+
+    struct E2EResult {
+        std::string mode;
+        size_t tags{};
+        double seconds{};
+        uint64_t values{};
+        uint64_t requests{};
+        uint64_t publishes{};
+        double p50{}, p99{}, p999{};
+        double acquireP50{}, acquireP99{};
+        double cpuSeconds{};
+        size_t rssKiB{};
+    };
+
+    double percentile(const std::vector<double>& sorted, double q) {
+        if (sorted.empty()) return 0.0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * q))];
+    }
+
+    void finishResult(E2EResult& r, AgeRecorder& ages, AgeRecorder& acquired, double cpuSeconds, double seconds) {
+        std::sort(ages.agesMs.begin(), ages.agesMs.end());
+        std::sort(acquired.agesMs.begin(), acquired.agesMs.end());
+        r.seconds = seconds;
+        r.values = ages.values;
+        r.p50 = percentile(ages.agesMs, 0.50);
+        r.p99 = percentile(ages.agesMs, 0.99);
+        r.p999 = percentile(ages.agesMs, 0.999);
+        r.acquireP50 = percentile(acquired.agesMs, 0.50);
+        r.acquireP99 = percentile(acquired.agesMs, 0.99);
+        r.cpuSeconds = cpuSeconds;
+        r.rssKiB = residentKiB();
+    }
+
+    // One "Load" device over the simulator's load tags, as the console would
+    // build it from a schema file.
+    DeviceSchema loadSchema(size_t tagCount, uint32_t historyDepth = 0) {
+        DeviceDescriptor load{"Load", "Load", {}};
+        char name[40];
+        for (size_t i = 0; i < tagCount; i++) {
+            std::snprintf(name, sizeof(name), "Tag%06zu", i);
+            TagDescriptor tag{name, name, "", &UA_TYPES[UA_TYPES_DOUBLE], true, false};
+            tag.historyDepth = historyDepth;
+            load.tags.push_back(tag);
+        }
+        DeviceSchema schema;
+        schema.addDevice(std::move(load));
+        return schema;
+    }
+
+    uint64_t requestCount(const OPCUAClient& client, OPCUAClientPool* pool) {
+        uint64_t requests = client.getHealth().requests;
+        for (size_t i = 0; pool && i < pool->size(); i++) {
+            requests += pool->session(i).getHealth().requests;
+        }
+        return requests;
+    }
+
+    // Drives the real acquisition path (worker, deadband, history, snapshot
+    // publish) and observes it the way the UIs do, through getCurrentData().
+    // A row counts as a new value when its clientTs moves, so publishes the
+    // consumer skipped are not lost from the count.
+    E2EResult runManager(const std::string& label, OPCUAClient& client, OPCUAClientPool* pool,
+                         const DeviceRegistry& registry, AcquisitionMode mode,
+                         int intervalMs, int durationMs, int warmupMs) {
+        AsyncDataManager manager(&client, &registry, intervalMs, mode, intervalMs, intervalMs);
+        if (pool) manager.setClientPool(pool);
+
+        AgeRecorder ages;
+        AgeRecorder acquired;
+        ages.agesMs.reserve(4 << 20);
+        acquired.agesMs.reserve(4 << 20);
+
+        E2EResult result;
+        result.mode = label;
+        result.tags = registry.getTags().size();
+        std::vector<int64_t> seenClientTs(result.tags, 0);
+
+        manager.start();
+        auto start = std::chrono::steady_clock::now();
+        auto measureFrom = start + std::chrono::milliseconds(warmupMs);
+        auto deadline = measureFrom + std::chrono::milliseconds(durationMs);
+        double cpuStart = 0.0;
+        uint64_t requestsStart = 0;
+        uint64_t sequenceStart = 0;
+        uint64_t lastSequence = 0;
+
+        while (std::chrono::steady_clock::now() < deadline) {
+            auto data = manager.getCurrentData();
+            if (!ages.recording && std::chrono::steady_clock::now() >= measureFrom) {
+                ages.recording = acquired.recording = true;
+                cpuStart = processCpuSeconds();
+                requestsStart = requestCount(client, pool);
+                sequenceStart = data->sequence;
+            }
+
+            if (data->sequence != lastSequence) {
+                lastSequence = data->sequence;
+                double now = wallClockSeconds();
+                for (size_t t = 0; t < data->values.size(); t++) {
+                    if (data->clientTs[t] == seenClientTs[t] || !data->isUsable(t)) continue;
+                    seenClientTs[t] = data->clientTs[t];
+                    ages.add(data->values[t], now);
+                    acquired.add(data->values[t], data->clientTs[t] / 1e6);
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        double cpuSeconds = processCpuSeconds() - cpuStart;
+        result.requests = requestCount(client, pool) - requestsStart;
+        result.publishes = lastSequence - sequenceStart;
+        manager.stop();
+
+        finishResult(result, ages, acquired, cpuSeconds, durationMs / 1000.0);
+        return result;
+    }
+
+    void printJson(std::ostream& out, const std::string& endpoint, bool inProcessServer, int updateMs,
+                   int intervalMs, const std::vector<E2EResult>& results) {
+        out << std::fixed << std::setprecision(3)
+            << "{\n  \"benchmark\": \"e2e\",\n"
+            << "  \"endpoint\": \"" << endpoint << "\",\n"
+            << "  \"inProcessServer\": " << (inProcessServer ? "true" : "false") << ",\n"
+            << "  \"serverUpdateMs\": " << updateMs << ",\n"
+            << "  \"intervalMs\": " << intervalMs << ",\n"
+            << "  \"results\": [";
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            auto perSecond = [&](double x) { return r.seconds > 0 ? x / r.seconds : 0.0; };
+            double cpuPercent = perSecond(r.cpuSeconds) * 100.0;
+            out << (i ? "," : "") << "\n    {"
+                << "\"mode\": \"" << r.mode << "\", "
+                << "\"tags\": " << r.tags << ", "
+                << "\"valuesPerSec\": " << perSecond(r.values) << ", "
+                << "\"requestsPerSec\": " << perSecond(r.requests) << ", "
+                << "\"publishesPerSec\": " << perSecond(r.publishes) << ", "
+                << "\"ageMs\": {\"p50\": " << r.p50 << ", \"p99\": " << r.p99 << ", \"p999\": " << r.p999 << "}, "
+                << "\"acquireMs\": {\"p50\": " << r.acquireP50 << ", \"p99\": " << r.acquireP99 << "}, "
+                << "\"processCpuPercent\": " << cpuPercent << ", "
+                << "\"cpuPercentPer1kTags\": " << cpuPercent * 1000.0 / r.tags << ", "
+                << "\"rssKiB\": " << r.rssKiB << "}";
+        }
+
+        out << "\n  ]\n}" << std::endl;
+    }
+
+    // ageMs is value age when the consumer first sees it in a snapshot,
+    // acquireMs when the worker stored it (clientTs).
+    int benchEndToEnd(size_t maxTags, int durationMs, int updateMs, const std::string& externalEndpoint,
+                      size_t poolSessions) {
+        const int intervalMs = 50;
+        const int warmupMs = 500;
+        const uint32_t historyDepth = 16;
+
+        std::unique_ptr<SimServer> server;
+        std::string endpoint = externalEndpoint;
+
+        if (endpoint.empty()) {
+            SimServerConfig config;
+            config.port = 4841;
+            config.loadTags = maxTags;
+            config.updateIntervalMs = updateMs;
+            config.clockValues = true;
+
+            std::cerr << "Starting simulation server with " << maxTags << " load tags..." << std::endl;
+            server = std::make_unique<SimServer>(config);
+            if (!server->start()) return 1;
+            endpoint = server->getEndpoint();
+        }
+
+        OPCUAClient client(endpoint);
+        if (!client.connect()) {
+            std::cerr << "Failed to connect to " << endpoint << std::endl;
+            return 1;
+        }
+
+        OPCUAClientPool pool(endpoint, poolSessions + 1);
+        if (poolSessions > 0 && pool.connect()) {
+            pool.start();
+        }
+
+        OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+        std::vector<E2EResult> results;
+        for (size_t tags = 10; tags <= maxTags; tags *= 10) {
+            DeviceRegistry registry(loadSchema(tags, historyDepth));
+            if (!registry.resolve(client, objectsFolder, "")) {
+                std::cerr << "Load tags not found" << std::endl;
+                return 1;
+            }
+
+            std::cerr << "polling " << tags << " tags" << std::endl;
+            results.push_back(runManager("polling", client, nullptr, registry, AcquisitionMode::Polling,
+                                         intervalMs, durationMs, warmupMs));
+
+            std::cerr << "subscription " << tags << " tags" << std::endl;
+            results.push_back(runManager("subscription", client, nullptr, registry, AcquisitionMode::Subscription,
+                                         intervalMs, durationMs, warmupMs));
+
+            if (pool.isRunning()) {
+                std::cerr << "pooled polling " << tags << " tags" << std::endl;
+                results.push_back(runManager("pooled-" + std::to_string(pool.readSessionCount()), client, &pool,
+                                             registry, AcquisitionMode::Polling, intervalMs, durationMs, warmupMs));
+            }
+        }
+
+        pool.disconnect();
+        client.disconnect();
+        printJson(std::cout, endpoint, server != nullptr, updateMs, intervalMs, results);
+        return 0;
+    }
+
+    // Without an external base port the servers run in-process, so the CPU
+    // figure includes them; start KursovayaSimServer instances on consecutive
+    // ports and pass the first one to measure the client alone.
+    int benchFanIn(size_t serverCount, size_t tagsPerServer, int durationMs, int externalBasePort) {
+        const int intervalMs = 100;
+
+        std::vector<std::unique_ptr<SimServer>> servers;
+        std::vector<std::string> urls;
+        for (size_t i = 0; i < serverCount; i++) {
+            if (externalBasePort > 0) {
+                urls.push_back("opc.tcp://127.0.0.1:" + std::to_string(externalBasePort + i));
+                continue;
+            }
+
+            SimServerConfig config;
+            config.port = static_cast<uint16_t>(4900 + i);
+            config.loadTags = tagsPerServer;
+            config.updateIntervalMs = intervalMs;
+            auto server = std::make_unique<SimServer>(config);
+            if (!server->start()) return 1;
+            urls.push_back(server->getEndpoint());
+            servers.push_back(std::move(server));
+        }
+
+        std::vector<std::string> paths;
+        char name[40];
+        for (size_t i = 0; i < tagsPerServer; i++) {
+            std::snprintf(name, sizeof(name), "Load/Tag%06zu", i);
+            paths.push_back(name);
+        }
+
+        TagStore store;
+        ServerRegistry registry(store, paths);
+        for (size_t i = 0; i < urls.size(); i++) {
+            registry.addServer("cell" + std::to_string(i), urls[i], intervalMs);
+        }
+
+        registry.start();
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+
+        RegistryStats before = registry.getStats();
+        double cpuStart = processCpuSeconds();
+        std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+        double cpuSeconds = processCpuSeconds() - cpuStart;
+        RegistryStats after = registry.getStats();
+
+        registry.stop();
+        for (auto& server : servers) server->stop();
+
+        double seconds = durationMs / 1000.0;
+        double cpuPercent = cpuSeconds / seconds * 100.0;
+        std::cout << std::fixed << std::setprecision(3)
+                  << "{\"benchmark\": \"fanin\", \"servers\": " << serverCount
+                  << ", \"tagsPerServer\": " << tagsPerServer
+                  << ", \"workerThreads\": " << after.workerThreads
+                  << ", \"connected\": " << after.connectedServers
+                  << ", \"cyclesPerSec\": " << (after.cycles - before.cycles) / seconds
+                  << ", \"lateCycles\": " << after.lateCycles - before.lateCycles
+                  << ", \"cpuPercent\": " << cpuPercent
+                  << ", \"cpuPercentPerServer\": " << cpuPercent / std::max<size_t>(serverCount, 1)
+                  << ", \"inProcessServers\": " << (externalBasePort > 0 ? "false" : "true") << "}" << std::endl;
+        return 0;
+    }
+
+    // Each run starts from an empty browse cache. The 1x1 run is the
+    // one-node-per-round-trip baseline the batched runs are compared with.
+    int benchDiscover(size_t deviceCount, size_t tagsPerDevice, size_t nodesPerRequest, size_t maxInFlight,
+                      const std::string& externalEndpoint) {
+        std::unique_ptr<SimServer> server;
+        std::string endpoint = externalEndpoint;
+
+        if (endpoint.empty()) {
+            SimServerConfig config;
+            config.port = 4842;
+            config.devices = deviceCount;
+            config.tagsPerDevice = tagsPerDevice;
+
+            std::cerr << "Starting simulation server with " << deviceCount << " devices x "
+                      << tagsPerDevice << " tags..." << std::endl;
+            server = std::make_unique<SimServer>(config);
+            if (!server->start()) return 1;
+            endpoint = server->getEndpoint();
+        }
+
+        OPCUAClient client(endpoint);
+        if (!client.connect()) {
+            std::cerr << "Failed to connect to " << endpoint << std::endl;
+            return 1;
+        }
+
+        OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+        const std::pair<size_t, size_t> runs[] = {
+            {1, 1}, {nodesPerRequest, 1}, {nodesPerRequest, maxInFlight}
+        };
+
+        int rc = 0;
+        for (const auto& [perRequest, inFlight] : runs) {
+            DiscoveryOptions options;
+            options.nodesPerRequest = perRequest;
+            options.maxInFlight = inFlight;
+
+            client.clearBrowseCache();
+            uint64_t requestsBefore = client.browseRequestCount();
+            std::vector<DiscoveredNode> found;
+
+            auto start = std::chrono::steady_clock::now();
+            bool complete = client.discover(objectsFolder, found, options);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            size_t variables = std::count_if(found.begin(), found.end(), [](const DiscoveredNode& n) {
+                return n.nodeClass == UA_NODECLASS_VARIABLE;
+            });
+            if (!complete) rc = 2;
+
+            std::cout << std::fixed << std::setprecision(3)
+                      << "{\"benchmark\": \"discover\", \"nodes\": " << found.size()
+                      << ", \"variables\": " << variables
+                      << ", \"nodesPerRequest\": " << perRequest
+                      << ", \"maxInFlight\": " << inFlight
+                      << ", \"requests\": " << client.browseRequestCount() - requestsBefore
+                      << ", \"ms\": " << ms
+                      << ", \"nodesPerSec\": " << found.size() / std::max(ms / 1000.0, 1e-9)
+                      << ", \"complete\": " << (complete ? "true" : "false") << "}" << std::endl;
+        }
+
+        client.clearBrowseCache();
+        DeviceRegistry registry(DeviceSchema{});
+        DiscoveryOptions options;
+        options.nodesPerRequest = nodesPerRequest;
+        options.maxInFlight = maxInFlight;
+
+        auto start = std::chrono::steady_clock::now();
+        registry.discover(client, objectsFolder, options);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "{\"benchmark\": \"discover-registry\", \"devices\": " << registry.deviceCount()
+                  << ", \"tags\": " << registry.tagCount()
+                  << ", \"ms\": " << ms << "}" << std::endl;
+
+        client.disconnect();
+        return rc;
+    }
+
+    // Load tags follow a sine of amplitude 100 over 10 s, so a tag moves by
+    // up to ~6 per 100 ms server update. Deadband 0 is plain change detection.
+    int benchDeadband(size_t tagCount, int durationMs, int updateMs) {
+        const int intervalMs = 50;
+        const double deadbands[] = {0.0, 0.5, 2.0, 10.0};
+
+        SimServerConfig config;
+        config.port = 4843;
+        config.loadTags = tagCount;
+        config.updateIntervalMs = updateMs;
+        SimServer server(config);
+        if (!server.start()) return 1;
+
+        OPCUAClient client(server.getEndpoint());
+        if (!client.connect()) {
+            std::cerr << "Failed to connect to " << server.getEndpoint() << std::endl;
+            return 1;
+        }
+
+        OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+        const AcquisitionMode modes[] = {AcquisitionMode::Polling, AcquisitionMode::Subscription};
+
+        for (double deadband : deadbands) {
+            DeviceDescriptor load{"Load", "Load", {}};
+            char name[40];
+            for (size_t i = 0; i < tagCount; i++) {
+                std::snprintf(name, sizeof(name), "Tag%06zu", i);
+                TagDescriptor tag{name, name, "", &UA_TYPES[UA_TYPES_DOUBLE], true, false};
+                tag.deadbandType = deadband > 0.0 ? UA_DEADBANDTYPE_ABSOLUTE : UA_DEADBANDTYPE_NONE;
+                tag.deadband = deadband;
+                load.tags.push_back(tag);
+            }
+            DeviceSchema schema;
+            schema.addDevice(std::move(load));
+
+            DeviceRegistry registry(schema);
+            if (!registry.resolve(client, objectsFolder, "")) {
+                std::cerr << "Load tags not found" << std::endl;
+                return 1;
+            }
+
+            for (AcquisitionMode mode : modes) {
+                AsyncDataManager manager(&client, &registry, intervalMs, mode, intervalMs, intervalMs);
+                manager.start();
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+
+                uint64_t firstSequence = manager.getCurrentData()->sequence;
+                uint64_t lastSequence = firstSequence;
+                uint64_t observed = 0;
+                uint64_t dirtyTags = 0;
+                double cpuStart = processCpuSeconds();
+                auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(durationMs);
+
+                while (std::chrono::steady_clock::now() < end) {
+                    auto data = manager.getCurrentData();
+                    if (data->sequence == lastSequence + 1) {
+                        data->forEachDirty([&](size_t) { dirtyTags++; });
+                        observed++;
+                    }
+                    lastSequence = data->sequence;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+
+                double cpuSeconds = processCpuSeconds() - cpuStart;
+                manager.stop();
+
+                double seconds = durationMs / 1000.0;
+                std::cout << std::fixed << std::setprecision(3)
+                          << "{\"benchmark\": \"deadband\", \"mode\": \""
+                          << (mode == AcquisitionMode::Polling ? "polling" : "subscription")
+                          << "\", \"tags\": " << tagCount
+                          << ", \"deadband\": " << deadband
+                          << ", \"publishesPerSec\": " << (lastSequence - firstSequence) / seconds
+                          << ", \"dirtyTagsPerPublish\": " << (observed ? double(dirtyTags) / observed : 0.0)
+                          << ", \"dirtyFraction\": "
+                          << (observed ? double(dirtyTags) / observed / std::max<size_t>(tagCount, 1) : 0.0)
+                          << ", \"cpuPercent\": " << cpuSeconds / seconds * 100.0 << "}" << std::endl;
+            }
+        }
+
+        client.disconnect();
+        server.stop();
+        return 0;
+    }
+
+    // Torn-snapshot stress test of the published DeviceData. With clockValues
+    // every load tag carries the same value after each server update and one
+    // Read returns them all, so a consistent snapshot has equal values and
+    // equal clientTs across all rows; anything else is a mix of two publishes.
+    int benchSnapshot(size_t tagCount, int readerCount, int durationMs) {
+        const size_t maxSamples = 1 << 20;
+
+        SimServerConfig config;
+        config.port = 4844;
+        config.loadTags = tagCount;
+        config.updateIntervalMs = 1;
+        config.clockValues = true;
+        SimServer server(config);
+        if (!server.start()) return 1;
+
+        OPCUAClient client(server.getEndpoint());
+        if (!client.connect()) {
+            std::cerr << "Failed to connect to " << server.getEndpoint() << std::endl;
+            return 1;
+        }
+
+        DeviceRegistry registry(loadSchema(tagCount));
+        OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+        if (!registry.resolve(client, objectsFolder, "")) {
+            std::cerr << "Load tags not found" << std::endl;
+            return 1;
+        }
+
+        AsyncDataManager manager(&client, &registry, 1, AcquisitionMode::Polling);
+        manager.start();
+
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> tornSnapshots{0};
+        std::vector<std::vector<double>> readerSamples(readerCount);
+        std::vector<uint64_t> readerOps(readerCount, 0);
+        uint64_t firstSequence = manager.getCurrentData()->sequence;
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; r++) {
+            readerSamples[r].reserve(maxSamples);
+            readers.emplace_back([&, r]() {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    auto data = manager.getCurrentData();
+                    auto t1 = std::chrono::steady_clock::now();
+                    for (size_t t = 1; t < data->values.size(); t++) {
+                        if (data->values[t] != data->values[0] || data->clientTs[t] != data->clientTs[0]) {
+                            tornSnapshots.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        }
+                    }
+                    if (readerSamples[r].size() < maxSamples) {
+                        readerSamples[r].push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+                    }
+                    readerOps[r]++;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+        stop = true;
+        for (auto& t : readers) t.join();
+        uint64_t publishes = manager.getCurrentData()->sequence - firstSequence;
+        manager.stop();
+        client.disconnect();
+        server.stop();
+
+        std::vector<double> allReaderSamples;
+        uint64_t totalReads = 0;
+        for (int r = 0; r < readerCount; r++) {
+            allReaderSamples.insert(allReaderSamples.end(), readerSamples[r].begin(), readerSamples[r].end());
+            totalReads += readerOps[r];
+        }
+        auto rd = latencyStats(allReaderSamples);
+        double seconds = durationMs / 1000.0;
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "{\"benchmark\": \"snapshot\", \"tags\": " << tagCount
+                  << ", \"readers\": " << readerCount
+                  << ", \"publishesPerSec\": " << publishes / seconds
+                  << ", \"readsPerSec\": " << totalReads / seconds
+                  << ", \"readP50Ns\": " << rd.p50 << ", \"readP99Ns\": " << rd.p99
+                  << ", \"readMaxNs\": " << rd.max
+                  << ", \"tornSnapshots\": " << tornSnapshots.load() << "}" << std::endl;
+
+        return tornSnapshots.load() == 0 ? 0 : 2;
+    }
+
+    void printUsage() {
+        std::cout << "Usage: KursovayaBench read [endpoint] [iterations]" << std::endl
+                  << "       KursovayaBench seqlock [readers] [durationMs]" << std::endl
+                  << "       KursovayaBench snapshot [tags] [readers] [durationMs]" << std::endl
+                  << "       KursovayaBench history [tags] [aggregateRateHz] [durationMs]" << std::endl
+                  << "       KursovayaBench e2e [maxTags] [durationMs] [serverUpdateMs] [endpoint] [poolSessions]" << std::endl
+                  << "       KursovayaBench fanin [servers] [tagsPerServer] [durationMs] [externalBasePort]" << std::endl
+                  << "       KursovayaBench discover [devices] [tagsPerDevice] [nodesPerRequest] [maxInFlight] [endpoint]" << std::endl
+                  << "       KursovayaBench deadband [tags] [durationMs] [serverUpdateMs]" << std::endl;
+    }
+}
+
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+int main(int argc, char** argv) {
+    std::string scenario = argc > 1 ? argv[1] : "read";
+
+    if (scenario == "read") {
+        std::string endpoint = argc > 2 ? argv[2] : "opc.tcp://127.0.0.1:4840";
+        size_t iterations = argc > 3 ? std::stoul(argv[3]) : 1000;
+        return benchRead(endpoint, iterations);
+    }
+
+    if (scenario == "seqlock") {
+        int readers = argc > 2 ? std::stoi(argv[2]) : 4;
+        int durationMs = argc > 3 ? std::stoi(argv[3]) : 2000;
+        return benchSeqlock(readers, durationMs);
+    }
+
+    if (scenario == "snapshot") {
+        size_t tags = argc > 2 ? std::stoul(argv[2]) : 1000;
+        int readers = argc > 3 ? std::stoi(argv[3]) : 4;
+        int durationMs = argc > 4 ? std::stoi(argv[4]) : 3000;
+        return benchSnapshot(tags, readers, durationMs);
+    }
+
+    if (scenario == "history") {
+        int tags = argc > 2 ? std::stoi(argv[2]) : 100;
+        int rateHz = argc > 3 ? std::stoi(argv[3]) : 10000;
+        int durationMs = argc > 4 ? std::stoi(argv[4]) : 3000;
+        return benchHistory(tags, rateHz, durationMs);
+    }
+
+    if (scenario == "e2e") {
+        size_t maxTags = argc > 2 ? std::stoul(argv[2]) : 100000;
+        int durationMs = argc > 3 ? std::stoi(argv[3]) : 5000;
+        int updateMs = argc > 4 ? std::stoi(argv[4]) : 100;
+        std::string endpoint = argc > 5 ? argv[5] : "";
+        size_t poolSessions = argc > 6 ? std::stoul(argv[6]) : 4;
+        return benchEndToEnd(maxTags, durationMs, updateMs, endpoint, poolSessions);
+    }
+
+    if (scenario == "fanin") {
+        size_t servers = argc > 2 ? std::stoul(argv[2]) : 20;
+        size_t tags = argc > 3 ? std::stoul(argv[3]) : 100;
+        int durationMs = argc > 4 ? std::stoi(argv[4]) : 5000;
+        int basePort = argc > 5 ? std::stoi(argv[5]) : 0;
+        return benchFanIn(servers, tags, durationMs, basePort);
+    }
+
+    if (scenario == "discover") {
+        size_t devices = argc > 2 ? std::stoul(argv[2]) : 1000;
+        size_t tagsPerDevice = argc > 3 ? std::stoul(argv[3]) : 10;
+        size_t nodesPerRequest = argc > 4 ? std::stoul(argv[4]) : 500;
+        size_t maxInFlight = argc > 5 ? std::stoul(argv[5]) : 4;
+        std::string endpoint = argc > 6 ? argv[6] : "";
+        return benchDiscover(devices, tagsPerDevice, nodesPerRequest, maxInFlight, endpoint);
+    }
+
+    if (scenario == "deadband") {
+        size_t tags = argc > 2 ? std::stoul(argv[2]) : 1000;
+        int durationMs = argc > 3 ? std::stoi(argv[3]) : 5000;
+        int updateMs = argc > 4 ? std::stoi(argv[4]) : 100;
+        return benchDeadband(tags, durationMs, updateMs);
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,216 @@
+#include "client_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+namespace {
+    struct ReadLatch {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining{0};
+        size_t good{0};
+        bool abandoned{false};
+    };
+
+    bool takeResult(const AsyncReadResult& r, size_t i, std::pair<bool, double>& out) {
+        if (i >= r.values.size() || !r.values[i].first) return false;
+        out = r.values[i];
+        return true;
+    }
+
+    bool takeResult(const AsyncReadResult& r, size_t i, TagSample& out) {
+        if (i >= r.samples.size()) return false;
+        out = r.samples[i];
+        return !UA_StatusCode_isBad(out.status);
+    }
+}
+
+
+
+OPCUAClientPool::OPCUAClientPool(const std::string& endpoint, size_t sessionCount, bool dedicatedWriteSession)
+    : endpoint(endpoint), dedicatedWriteSession(dedicatedWriteSession) {
+    for (size_t i = 0; i < std::max<size_t>(sessionCount, 1); i++) {
+        auto session = std::make_unique<Session>();
+        session->client = std::make_unique<OPCUAClient>(endpoint);
+        session->client->enableAutoReconnect();
+        sessions.push_back(std::move(session));
+    }
+}
+
+OPCUAClientPool::~OPCUAClientPool() {
+    disconnect();
+}
+
+bool OPCUAClientPool::connect() {
+    for (size_t i = 0; i < sessions.size(); i++) {
+        if (!sessions[i]->client->connect()) {
+            std::cerr << "Pool session " << i << " failed to connect to " << endpoint << std::endl;
+            disconnect();
+            return false;
+        }
+        sessions[i]->connected = true;
+    }
+    return true;
+}
+
+void OPCUAClientPool::disconnect() {
+    stop();
+    for (auto& session : sessions) {
+        session->client->disconnect();
+        session->connected = false;
+    }
+}
+
+bool OPCUAClientPool::isConnected() const {
+    for (const auto& session : sessions) {
+        if (running ? !session->connected.load(std::memory_order_relaxed) : !session->client->isConnected()) {
+            return false;
+        }
+    }
+    return !sessions.empty();
+}
+
+void OPCUAClientPool::start() {
+    if (running) return;
+
+    running = true;
+    for (auto& session : sessions) {
+        session->thread = std::thread(&OPCUAClientPool::serviceLoop, this, session.get());
+    }
+}
+
+void OPCUAClientPool::stop() {
+    if (!running) return;
+
+    running = false;
+    for (auto& session : sessions) {
+        if (session->thread.joinable()) {
+            session->thread.join();
+        }
+    }
+}
+
+void OPCUAClientPool::serviceLoop(Session* session) {
+    while (running) {
+        bool ok = session->client->runIterate(10);
+        session->connected.store(ok, std::memory_order_relaxed);
+        if (!ok) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+size_t OPCUAClientPool::readSessionCount() const {
+    return dedicatedWriteSession && sessions.size() > 1 ? sessions.size() - 1 : sessions.size();
+}
+
+size_t OPCUAClientPool::readSessionIndex(size_t part) const {
+    size_t first = sessions.size() - readSessionCount();
+    return first + part % readSessionCount();
+}
+
+PartitionedRead OPCUAClientPool::prepareRead(const std::vector<OPCUANode>& nodes,
+                                             UA_TimestampsToReturn timestamps) const {
+    return prepareRead(nodes, {}, timestamps);
+}
+
+PartitionedRead OPCUAClientPool::prepareRead(const std::vector<OPCUANode>& nodes,
+                                             const std::vector<OPCUANode>& arrays,
+                                             UA_TimestampsToReturn timestamps) const {
+    PartitionedRead read;
+    if (nodes.empty() && arrays.empty()) return read;
+
+    size_t parts = std::max<size_t>(std::min(readSessionCount(), nodes.size()), 1);
+    size_t chunk = std::max<size_t>((nodes.size() + parts - 1) / parts, 1);
+    read.parts = std::make_shared<std::vector<PreparedRead>>();
+
+    size_t first = 0;
+    do {
+        size_t last = std::min(nodes.size(), first + chunk);
+        std::vector<OPCUANode> part(nodes.begin() + first, nodes.begin() + last);
+        const OPCUAClient& client = *sessions[readSessionIndex(read.parts->size())]->client;
+        read.offsets.push_back(first);
+        read.parts->push_back(last == nodes.size() ? client.prepareRead(part, arrays, timestamps)
+                                                   : client.prepareRead(part, timestamps));
+        first = last;
+    } while (first < nodes.size());
+
+    read.total = nodes.size();
+    read.arrayTotal = arrays.size();
+    return read;
+}
+
+size_t OPCUAClientPool::executeRead(const PartitionedRead& read, std::pair<bool, double>* out, size_t outSize) {
+    return executePartitioned(read, out, outSize);
+}
+
+size_t OPCUAClientPool::executeRead(const PartitionedRead& read, TagSample* out, size_t outSize) {
+    return executePartitioned(read, out, outSize);
+}
+
+size_t OPCUAClientPool::executeRead(const PartitionedRead& read, TagSample* out, size_t outSize,
+                                    VariantBuffer* arrays, size_t arrayCount) {
+    return executePartitioned(read, out, outSize, arrays, arrayCount);
+}
+
+template<typename T>
+size_t OPCUAClientPool::executePartitioned(const PartitionedRead& read, T* out, size_t outSize,
+                                           VariantBuffer* arrays, size_t arrayCount) {
+    size_t count = std::min(outSize, read.size());
+    arrayCount = std::min(arrayCount, read.arrayCount());
+    for (size_t i = 0; i < count; i++) {
+        out[i] = T();
+    }
+    for (size_t i = 0; i < arrayCount; i++) {
+        arrays[i].reset();
+    }
+    if (count + arrayCount == 0 || !running) return 0;
+
+    std::shared_ptr<std::vector<PreparedRead>> parts = read.parts;
+    auto latch = std::make_shared<ReadLatch>();
+    latch->remaining = parts->size();
+
+    for (size_t p = 0; p < parts->size(); p++) {
+        const PreparedRead& part = (*parts)[p];
+        size_t offset = read.offsets[p];
+        size_t n = offset < count ? std::min(part.size() - part.arrayCount(), count - offset) : 0;
+        T* target = out + offset;
+        size_t arrayN = std::min(part.arrayCount(), arrayCount);
+
+        auto onRead = [latch, parts, target, n, arrays, arrayN](AsyncReadResult& r) {
+            std::lock_guard<std::mutex> lock(latch->mutex);
+            if (latch->abandoned) return;
+
+            for (size_t i = 0; i < n; i++) {
+                if (takeResult(r, i, target[i])) latch->good++;
+            }
+            for (size_t i = 0; i < arrayN && i < r.arrays.size(); i++) {
+                arrays[i] = std::move(r.arrays[i]);
+                if (!arrays[i].empty()) latch->good++;
+            }
+
+            if (--latch->remaining == 0) {
+                latch->done.notify_all();
+            }
+        };
+
+        if (!session(readSessionIndex(p)).readAsync(part, onRead)) {
+            std::lock_guard<std::mutex> lock(latch->mutex);
+            latch->remaining--;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(latch->mutex);
+    if (!latch->done.wait_for(lock, std::chrono::milliseconds(readTimeoutMs),
+                              [&]() { return latch->remaining == 0; })) {
+        latch->abandoned = true;
+    }
+    return latch->good;
+}
+
+bool OPCUAClientPool::queueWrite(const OPCUANode& node, double value, QueuedWriteCallback callback,
+                                 const UA_DataType* type) {
+    return writeSession().queueWrite(node, value, std::move(callback), type);
+}
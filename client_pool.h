@@ -0,0 +1,97 @@
+#ifndef CLIENT_POOL_H
+#define CLIENT_POOL_H
+
+#include "opcua_client.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class PartitionedRead {
+private:
+    // Shared with the queued requests, which can outlive a read that gave up
+    // waiting for them.
+    std::shared_ptr<std::vector<PreparedRead>> parts;
+    std::vector<size_t> offsets;
+    size_t total{0};
+    size_t arrayTotal{0};
+
+    friend class OPCUAClientPool;
+
+public:
+    size_t size() const { return total; }
+    bool empty() const { return total == 0 && arrayTotal == 0; }
+    size_t arrayCount() const { return arrayTotal; }
+    size_t partCount() const { return parts ? parts->size() : 0; }
+};
+
+
+// N sessions to one endpoint, each owned by its own service thread once
+// start() is called. Sessions reconnect on their own with the default
+// backoff, driven by the service threads. Synchronous calls (browse,
+// resolveDevices, ...) on a session are only safe before start(); afterwards
+// use the async API, which is queued and executed on the session's thread.
+// With a dedicated write session, session 0 carries only writes and reads are
+// spread over the rest.
+class OPCUAClientPool {
+private:
+    struct Session {
+        std::unique_ptr<OPCUAClient> client;
+        std::thread thread;
+        std::atomic<bool> connected{false};
+    };
+
+    std::string endpoint;
+    std::vector<std::unique_ptr<Session>> sessions;
+    bool dedicatedWriteSession;
+    std::atomic<bool> running{false};
+    int readTimeoutMs{10000};
+
+    void serviceLoop(Session* session);
+    size_t readSessionIndex(size_t part) const;
+
+    template<typename T>
+    size_t executePartitioned(const PartitionedRead& read, T* out, size_t outSize,
+                              VariantBuffer* arrays = nullptr, size_t arrayCount = 0);
+
+public:
+    explicit OPCUAClientPool(const std::string& endpoint, size_t sessionCount = 4,
+                             bool dedicatedWriteSession = true);
+    ~OPCUAClientPool();
+
+    OPCUAClientPool(const OPCUAClientPool&) = delete;
+    OPCUAClientPool& operator=(const OPCUAClientPool&) = delete;
+
+    bool connect();
+    void disconnect();
+    bool isConnected() const;
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    size_t size() const { return sessions.size(); }
+    size_t readSessionCount() const;
+    OPCUAClient& session(size_t index) { return *sessions[index]->client; }
+    OPCUAClient& writeSession() { return *sessions[0]->client; }
+    const std::string& getEndpoint() const { return endpoint; }
+
+    PartitionedRead prepareRead(const std::vector<OPCUANode>& nodes,
+                                UA_TimestampsToReturn timestamps = UA_TIMESTAMPSTORETURN_NEITHER) const;
+    // Array nodes ride in the last part's request.
+    PartitionedRead prepareRead(const std::vector<OPCUANode>& nodes, const std::vector<OPCUANode>& arrays,
+                                UA_TimestampsToReturn timestamps) const;
+    size_t executeRead(const PartitionedRead& read, std::pair<bool, double>* out, size_t outSize);
+    size_t executeRead(const PartitionedRead& read, TagSample* out, size_t outSize);
+    size_t executeRead(const PartitionedRead& read, TagSample* out, size_t outSize,
+                       VariantBuffer* arrays, size_t arrayCount);
+
+    bool queueWrite(const OPCUANode& node, double value, QueuedWriteCallback callback = nullptr,
+                    const UA_DataType* type = nullptr);
+
+    void setReadTimeout(int ms) { readTimeoutMs = ms; }
+};
+
+#endif
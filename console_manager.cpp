@@ -5,6 +5,7 @@
 #include <thread>
 #include <ctime>
 #include <sstream>
+#include <algorithm>
 
 
 
@@ -71,9 +72,9 @@ void ConsoleManager::showCursor() {
 #endif
 }
 
-void ConsoleManager::printWelcome() {
+void ConsoleManager::printWelcome(const std::string& endpoint) {
     std::cout << "Клиент OPC UA запускается..." << std::endl;
-    std::cout << "Подключение к: opc.tcp://127.0.0.1:4840" << std::endl;
+    std::cout << "Подключение к: " << endpoint << std::endl;
     std::cout << std::endl;
 }
 
@@ -99,10 +100,9 @@ bool ConsoleManager::isKeyPressed() {
 
 
 
-OPCUAApplication::OPCUAApplication(const std::string& endpoint)
-    : client(endpoint), nodesFound(false), running(true), 
-      connectionLost(false), displayIntervalMs(16),
-      reconnectAttempts(0) {
+OPCUAApplication::OPCUAApplication(const std::string& endpoint, const DeviceSchema& schema)
+    : client(endpoint), devices(schema), nodesFound(false), running(true), 
+      connectionLost(false), displayIntervalMs(16) {
     
     objectsFolder = OPCUANode(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
 }
@@ -113,93 +113,144 @@ OPCUAApplication::~OPCUAApplication() {
 
 bool OPCUAApplication::initialize() {
     ConsoleManager::setupConsole();
-    ConsoleManager::printWelcome();
+    ConsoleManager::printWelcome(client.getEndpoint());
 
     if (!client.connect()) {
         std::cerr << "Не удалось подключиться к серверу" << std::endl;
         return false;
     }
+    client.enableAutoReconnect();
+    client.setTrafficStats(true);
 
     std::cout << "Подключено к серверу OPC UA" << std::endl;
     std::cout << "Поиск устройств..." << std::endl;
 
-    bool multimeterFound = multimeter.initialize(client, objectsFolder);
-    bool machineFound = machine.initialize(client, objectsFolder);
-    bool computerFound = computer.initialize(client, objectsFolder);
+    if (!resolveDevices()) {
+        std::cerr << "\nОШИБКА: Не найдено ни одного устройства." << std::endl;
+        std::cerr << "Убедитесь, что сервер запущен и создал переменные." << std::endl;
+        return false;
+    }
+
+    if (poolSize > 0) {
+        pool = std::make_unique<OPCUAClientPool>(client.getEndpoint(), poolSize);
+        if (pool->connect()) {
+            pool->start();
+            std::cout << "Пул сессий: " << pool->size() << std::endl;
+        } else {
+            std::cerr << "Не удалось открыть пул сессий, чтение через основную сессию" << std::endl;
+            pool.reset();
+        }
+    }
+
+    startAcquisition();
+    return true;
+}
 
-    if (multimeterFound) {
-        multimeter.printStatus();
+bool OPCUAApplication::resolveDevices() {
+    resolvedNamespaceGeneration = client.getNamespaceGeneration();
+
+    if (autoDiscover) {
+        devices.discover(client, objectsFolder);
+        std::cout << "Найдено устройств: " << devices.deviceCount()
+                  << ", переменных: " << devices.tagCount() << std::endl;
+    } else {
+        devices.resolve(client, objectsFolder);
     }
+    devices.printStatus();
+
+    nodesFound = devices.anyResolved();
+    return nodesFound;
+}
 
-    if (machineFound) {
-        machine.printStatus();
+void OPCUAApplication::startAcquisition() {
+    bool pipelined = pipelineDepth > 0 && !pool;
+    asyncManager = std::make_unique<AsyncDataManager>(
+        &client, &devices, 20,
+        pipelined ? AcquisitionMode::PipelinedPolling : AcquisitionMode::Polling);
+    if (pipelined) {
+        asyncManager->setPipelineDepth(pipelineDepth);
+    }
+    if (pool) {
+        asyncManager->setClientPool(pool.get());
     }
+    tagLines.clear();
+    shownSequence = 0;
+    asyncManager->start();
+}
 
-    if (computerFound) {
-        computer.printStatus();
+// The acquisition worker pumps the client, so it is stopped before the
+// registry resolves on this thread and replaced once the nodes are current.
+void OPCUAApplication::reresolveDevices() {
+    asyncManager->stop();
+    asyncManager.reset();
+
+    ConsoleManager::clearConsole();
+    std::cout << "Пространства имён сервера изменились, повторный поиск устройств..." << std::endl;
+    if (!resolveDevices()) {
+        std::cerr << "Устройства не найдены после изменения пространств имён" << std::endl;
     }
+    startAcquisition();
+}
 
-    nodesFound = multimeterFound || machineFound || computerFound;
+bool OPCUAApplication::initializeReplay(const std::string& directory, double speed, bool loop) {
+    ConsoleManager::setupConsole();
+    ConsoleManager::printWelcome(client.getEndpoint());
 
-    if (!nodesFound) {
-        std::cerr << "\nОШИБКА: Не найдено ни одного устройства." << std::endl;
-        std::cerr << "Убедитесь, что сервер запущен и создал переменные." << std::endl;
+    replay = std::make_unique<ReplaySource>();
+    if (!replay->load(directory)) {
+        std::cerr << "Не удалось загрузить запись из " << directory << std::endl;
+        replay.reset();
         return false;
     }
+    replay->setSpeed(speed);
+    replay->setLoop(loop);
 
-    
-    asyncManager = std::make_unique<AsyncDataManager>(&client, &multimeter, &machine, &computer, 20);
+    std::cout << "Воспроизведение записи " << directory << ": "
+              << replay->sampleCount() << " значений" << std::endl;
+
+    nodesFound = true;
+    asyncManager = std::make_unique<AsyncDataManager>(replay.get(), &devices, 20);
     asyncManager->start();
 
     return true;
 }
 
-bool OPCUAApplication::reconnect() {
-    if (reconnectAttempts >= maxReconnectAttempts) {
-        std::cerr << "Достигнуто максимальное количество попыток переподключения" << std::endl;
-        return false;
+bool OPCUAApplication::initializeServers(const std::vector<std::pair<std::string, std::string>>& endpoints) {
+    ConsoleManager::setupConsole();
+    for (const auto& [name, url] : endpoints) {
+        ConsoleManager::printWelcome(name + " (" + url + ")");
     }
-    
-    reconnectAttempts++;
-    std::cout << "\nПопытка переподключения #" << reconnectAttempts << "..." << std::endl;
-    
-    
-    if (asyncManager) {
-        asyncManager->stop();
-        asyncManager.reset();
+
+    const TagTable& tags = devices.getTags();
+    std::vector<std::string> paths;
+    for (size_t t = 0; t < tags.size(); t++) {
+        if (tags.readable[t] && !tags.arrays[t]) paths.push_back(tags.paths[t]);
     }
-    
-    
-    client.disconnect();
-    
-   
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-    
-    
-    if (client.connect()) {
-        
-        multimeter.initialize(client, objectsFolder);
-        machine.initialize(client, objectsFolder);
-        computer.initialize(client, objectsFolder);
-        
-        
-        asyncManager = std::make_unique<AsyncDataManager>(&client, &multimeter, &machine, &computer, 20);
-        asyncManager->start();
-        
-        reconnectAttempts = 0;
-        connectionLost = false;
-        std::cout << "Переподключение успешно!" << std::endl;
-        return true;
+
+    store = std::make_unique<TagStore>();
+    servers = std::make_unique<ServerRegistry>(*store, paths);
+    for (const auto& [name, url] : endpoints) {
+        serverIds.push_back(servers->addServer(name, url, 100));
     }
-    
-    return false;
+    servers->start();
+
+    std::cout << "Опрос серверов: " << servers->serverCount() << ", переменных на сервер: "
+              << paths.size() << std::endl;
+
+    nodesFound = true;
+    return true;
 }
 
 bool OPCUAApplication::checkConnection() {
-    bool connected = client.isConnected();
+    if (replay || servers) return true;
+
+    bool connected = client.isSessionUp();
     if (!connected && !connectionLost) {
         connectionLost = true;
         std::cerr << "\nПотеряно соединение с сервером!" << std::endl;
+    } else if (connected && connectionLost) {
+        connectionLost = false;
+        std::cout << "\nСоединение восстановлено за " << client.lastRecoveryTimeMs() << " мс" << std::endl;
     }
     return connected;
 }
@@ -214,6 +265,7 @@ void OPCUAApplication::run() {
 
     auto lastDisplayTime = std::chrono::high_resolution_clock::now();
     auto lastConnectionCheck = std::chrono::high_resolution_clock::now();
+    auto lastLostScreen = lastConnectionCheck - std::chrono::seconds(1);
     bool paused = false;
     
     while (running) {
@@ -222,12 +274,11 @@ void OPCUAApplication::run() {
         auto elapsedCheck = std::chrono::duration_cast<std::chrono::milliseconds>(
             currentTime - lastConnectionCheck).count();
         
-        if (elapsedCheck >= 2000) {
-            if (!checkConnection() && connectionLost) {
-                if (!reconnect()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(2000));
-                    continue;
-                }
+        if (elapsedCheck >= 250) {
+            checkConnection();
+            client.expireWrites();
+            if (asyncManager && !replay && client.getNamespaceGeneration() != resolvedNamespaceGeneration) {
+                reresolveDevices();
             }
             lastConnectionCheck = currentTime;
         }
@@ -258,10 +309,13 @@ void OPCUAApplication::run() {
             }
         } else {
             if (connectionLost) {
-                ConsoleManager::clearConsole();
-                std::cout << "СОЕДИНЕНИЕ ПОТЕРЯНО" << std::endl;
-                std::cout << "Попытка переподключения..." << std::endl;
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                if (currentTime - lastLostScreen >= std::chrono::seconds(1)) {
+                    ConsoleManager::clearConsole();
+                    std::cout << "СОЕДИНЕНИЕ ПОТЕРЯНО" << std::endl;
+                    std::cout << "Попытка переподключения в фоне..." << std::endl;
+                    lastLostScreen = currentTime;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             } else {
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
@@ -275,9 +329,15 @@ void OPCUAApplication::shutdown() {
     if (asyncManager) {
         asyncManager->stop();
     }
+    if (servers) {
+        servers->stop();
+    }
     
     ConsoleManager::showCursor();
     std::cout << "\nОтключение от сервера..." << std::endl;
+    if (pool) {
+        pool->disconnect();
+    }
     client.disconnect();
     std::cout << "Клиент остановлен." << std::endl;
 }
@@ -307,7 +367,8 @@ void OPCUAApplication::handleInput() {
 }
 
 void OPCUAApplication::handleRPMInput() {
-    if (!machine.getTargetRPMNode().isValid()) {
+    size_t tag = devices.builtinRow(BuiltinTags::MachineTargetRPM);
+    if (tag == DeviceRegistry::npos || !devices.getTags().nodes[tag].isValid()) {
         std::cerr << "\nУзел целевых оборотов не найден" << std::endl;
         return;
     }
@@ -325,9 +386,18 @@ void OPCUAApplication::handleRPMInput() {
         if (newRpm < 0.0) newRpm = 0.0;
         if (newRpm > 3000.0) newRpm = 3000.0;
         
-        if (machine.setTargetRPM(client, newRpm)) {
-            std::cout << "Успешно установлены целевые обороты: " << newRpm << " об/мин" << std::endl;
-        } else {
+        bool queued = writeTag(tag, newRpm, [](const QueuedWriteResult& result) {
+            if (result.coalesced) return;
+            if (result.status == UA_STATUSCODE_GOOD) {
+                std::cout << "Успешно установлены целевые обороты: " << result.value << " об/мин ("
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(result.latency).count()
+                          << " мс)" << std::endl;
+            } else {
+                std::cerr << "Ошибка записи значения оборотов: "
+                          << UA_StatusCode_name(result.status) << std::endl;
+            }
+        });
+        if (!queued) {
             std::cerr << "Ошибка записи значения оборотов" << std::endl;
         }
     } catch (const std::exception& e) {
@@ -335,8 +405,14 @@ void OPCUAApplication::handleRPMInput() {
     }
 }
 
+bool OPCUAApplication::writeTag(size_t tag, double value, QueuedWriteCallback callback) {
+    return pool ? devices.write(*pool, tag, value, std::move(callback))
+                : devices.write(client, tag, value, std::move(callback));
+}
+
 void OPCUAApplication::handleControlModeInput() {
-    if (!machine.getControlModeNode().isValid()) {
+    size_t tag = devices.builtinRow(BuiltinTags::MachineControlMode);
+    if (tag == DeviceRegistry::npos || !devices.getTags().nodes[tag].isValid()) {
         std::cerr << "\nУзел режима управления не найден" << std::endl;
         return;
     }
@@ -354,9 +430,16 @@ void OPCUAApplication::handleControlModeInput() {
         int mode = std::stoi(input);
         
         if (mode == 0 || mode == 1) {
-            if (machine.setControlMode(client, mode)) {
-                std::cout << "Режим управления изменен на: " << (mode == 0 ? "АВТОМАТИЧЕСКИЙ" : "РУЧНОЙ") << std::endl;
-            } else {
+            bool queued = writeTag(tag, mode, [mode](const QueuedWriteResult& result) {
+                if (result.coalesced) return;
+                if (result.status == UA_STATUSCODE_GOOD) {
+                    std::cout << "Режим управления изменен на: " << (mode == 0 ? "АВТОМАТИЧЕСКИЙ" : "РУЧНОЙ") << std::endl;
+                } else {
+                    std::cerr << "Ошибка изменения режима управления: "
+                              << UA_StatusCode_name(result.status) << std::endl;
+                }
+            });
+            if (!queued) {
                 std::cerr << "Ошибка изменения режима управления" << std::endl;
             }
         } else {
@@ -368,6 +451,10 @@ void OPCUAApplication::handleControlModeInput() {
 }
 
 void OPCUAApplication::readAndDisplayValues() {
+    if (servers) {
+        displayServers();
+        return;
+    }
     
     auto data = asyncManager->getCurrentData();
     
@@ -388,17 +475,31 @@ void OPCUAApplication::readAndDisplayValues() {
     std::cout << "Данные OPC UA - " << std::ctime(&now_time);
     std::cout << "Обновление: " 
               << std::chrono::duration_cast<std::chrono::milliseconds>(
-                  now - data.lastUpdate).count() 
+                  now - data->lastUpdate).count() 
               << " мс назад\n";
     std::cout << "Частота: " << (1000 / displayIntervalMs) << " FPS\n";
     
     
     std::cout << "Статус: " << (connectionLost ? "ОТКЛЮЧЕНО" : "ПОДКЛЮЧЕНО") << "\n";
+    if (!replay) {
+        ConnectionHealth health = client.getHealth();
+        std::cout << "Канал: RTT " << std::fixed << std::setprecision(1) << health.rttMs
+                  << " ±" << health.rttVarMs << " мс, тайм-ауты " << health.requestTimeouts
+                  << ", продлений ожидается ~" << health.expectedChannelRenewals
+                  << ", ↑" << health.bytesSent / 1024 << " КБ ↓" << health.bytesReceived / 1024 << " КБ\n";
+    }
+    if (asyncManager->getMode() == AcquisitionMode::PipelinedPolling) {
+        AsyncDataManager::PipelineStats stats = asyncManager->getPipelineStats();
+        std::cout << "Конвейер (глубина " << asyncManager->getPipelineDepth() << "): выдано " << stats.issued
+                  << ", получено " << stats.completed << ", пропущено " << stats.dropped
+                  << ", опоздало " << stats.late << ", ошибок " << stats.failed
+                  << ", RTT " << std::fixed << std::setprecision(1) << stats.lastRttMs << " мс\n";
+    }
     
     std::cout << "===========================================\n";
     
     
-    displayAllDevicesAsync(data);
+    displayAllDevicesAsync(*data);
     
     
     std::cout << "\nУправление станциком:\n";
@@ -411,56 +512,115 @@ void OPCUAApplication::readAndDisplayValues() {
     std::cout.flush();
 }
 
+void OPCUAApplication::formatTagLine(const DeviceData& data, size_t tag) {
+    const TagTable& tags = devices.getTags();
+    if (!tags.readable[tag]) return;
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2);
+    line << "  " << tags.displayNames[tag] << ": " << data.values[tag] << " " << tags.units[tag];
+    if (!data.isUsable(tag)) {
+        line << " [" << UA_StatusCode_name(data.status[tag]) << "]";
+    } else if (data.sourceTs[tag] != 0) {
+        line << " (возраст: " << (data.clientTs[tag] - data.sourceTs[tag]) / 1000 << " мс)";
+    }
+    line << "\n";
+    tagLines[tag] = line.str();
+}
+
 void OPCUAApplication::displayAllDevicesAsync(const DeviceData& data) {
     std::ostringstream buffer;
-    
-    if (data.multimeter.valid) {
-        buffer << "\n[МУЛЬТИМЕТР] ";
-        buffer << "(задержка: " 
-               << std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::system_clock::now() - data.multimeter.timestamp).count()
-               << " мс)\n";
-        
-        buffer << "  Напряжение: " << std::fixed << std::setprecision(2) 
-               << data.multimeter.voltage << " В\n";
-        buffer << "  Ток: " << data.multimeter.current << " А\n";
-        buffer << "  Сопротивление: " << data.multimeter.resistance << " Ом\n";
-        buffer << "  Мощность: " << data.multimeter.power << " Вт\n";
-    } else {
-        buffer << "\n[МУЛЬТИМЕТР] Нет данных\n";
+
+    const TagTable& tags = devices.getTags();
+    if (data.sequence != shownSequence) {
+        bool incremental = data.sequence == shownSequence + 1 && tagLines.size() == tags.size() &&
+                           data.values.size() == tags.size();
+        tagLines.resize(tags.size());
+        if (incremental) {
+            data.forEachDirty([&](size_t t) { formatTagLine(data, t); });
+        } else {
+            for (size_t t = 0; t < tags.size() && t < data.values.size(); t++) formatTagLine(data, t);
+        }
+        shownSequence = data.sequence;
     }
-    
-    if (data.machine.valid) {
-        buffer << "\n[СТАНОК] ";
-        buffer << "(задержка: " 
-               << std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::system_clock::now() - data.machine.timestamp).count()
-               << " мс)\n";
-        
-        buffer << "  Обороты маховика: " << data.machine.rpm << " об/мин\n";
-        buffer << "  Мощность: " << data.machine.power << " кВт\n";
-        buffer << "  Напряжение: " << data.machine.voltage << " В\n";
-        buffer << "  Потребление энергии: " << data.machine.energy << " кВт·ч\n";
-    } else {
-        buffer << "\n[СТАНОК] Нет данных\n";
+
+    for (const auto& device : devices.getDevices()) {
+        if (device.getIndex() >= data.deviceValid.size() || !data.deviceValid[device.getIndex()]) {
+            buffer << "\n[" << device.getDisplayName() << "] Нет данных\n";
+            continue;
+        }
+
+        int64_t receivedUs = 0;
+        for (size_t t = device.getFirstTag(); t < device.getEndTag(); t++) {
+            receivedUs = std::max(receivedUs, data.clientTs[t]);
+        }
+        int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        buffer << "\n[" << device.getDisplayName() << "] ";
+        buffer << "(изменено " << (nowUs - receivedUs) / 1000 << " мс назад)\n";
+
+        for (size_t t = device.getFirstTag(); t < device.getEndTag(); t++) {
+            buffer << tagLines[t];
+        }
     }
     
-    if (data.computer.valid) {
-        buffer << "\n[КОМПЬЮТЕР] ";
-        buffer << "(задержка: " 
-               << std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::system_clock::now() - data.computer.timestamp).count()
-               << " мс)\n";
-        
-        buffer << "  Вентилятор 1: " << data.computer.fan1 << " об/мин\n";
-        buffer << "  Вентилятор 2: " << data.computer.fan2 << " об/мин\n";
-        buffer << "  Вентилятор 3: " << data.computer.fan3 << " об/мин\n";
-        buffer << "  Загрузка ЦП: " << data.computer.cpuLoad << " %\n";
-        buffer << "  Загрузка ГП: " << data.computer.gpuLoad << " %\n";
-        buffer << "  Использование ОЗУ: " << data.computer.ramUsage << " %\n";
+    std::cout << buffer.str();
+}
+
+void OPCUAApplication::displayServers() {
+    static bool firstRun = true;
+    if (firstRun) {
+        ConsoleManager::clearConsole();
+        firstRun = false;
     } else {
-        buffer << "\n[КОМПЬЮТЕР] Нет данных\n";
+        ConsoleManager::moveCursorToTop();
     }
-    
+
+    auto now = std::chrono::system_clock::now();
+    auto now_time = std::chrono::system_clock::to_time_t(now);
+    int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    RegistryStats stats = servers->getStats();
+
+    std::ostringstream buffer;
+    buffer << std::fixed << std::setprecision(2);
+    buffer << "===========================================\n";
+    buffer << "Данные OPC UA - " << std::ctime(&now_time);
+    buffer << "Серверы: подключено " << stats.connectedServers << " из " << servers->serverCount()
+           << ", циклов " << stats.cycles << ", опоздало " << stats.lateCycles << "\n";
+    buffer << "===========================================\n";
+
+    const TagTable& tags = devices.getTags();
+    for (uint32_t id : serverIds) {
+        ServerStatus status = servers->getStatus(id);
+        buffer << "\n== " << status.name << " (" << status.url << "): "
+               << (status.connected ? "ПОДКЛЮЧЕНО" : "ОТКЛЮЧЕНО");
+        if (!status.connected && status.failures > 0) buffer << ", неудачных попыток " << status.failures;
+        buffer << "\n";
+
+        for (const auto& device : devices.getDevices()) {
+            buffer << "[" << device.getDisplayName() << "]\n";
+            for (size_t t = device.getFirstTag(); t < device.getEndTag(); t++) {
+                TagValue value;
+                if (!store->read(id, tags.paths[t], value)) continue;
+
+                buffer << "  " << tags.displayNames[t] << ": ";
+                if (value.valid) {
+                    buffer << value.value << " " << tags.units[t]
+                           << " (" << (nowUs - value.timestampUs) / 1000 << " мс назад)";
+                } else if (value.quality) {
+                    buffer << UA_StatusCode_name(value.quality);
+                } else {
+                    buffer << "нет данных";
+                }
+                buffer << "\n";
+            }
+        }
+    }
+
+    buffer << "\n  'q' - выход\n";
+    buffer << "===========================================\n";
+
     std::cout << buffer.str();
-}
\ No newline at end of file
+    std::cout.flush();
+}
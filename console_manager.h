@@ -4,11 +4,15 @@
 #include "opcua_client.h"
 #include "device_managers.h"
 #include "async_manager.h"
+#include "server_registry.h"
+#include "tag_store.h"
 #include <conio.h>
 #include <windows.h>
 #include <string>
 #include <atomic>
 #include <memory>
+#include <utility>
+#include <vector>
 
 
 class ConsoleManager {
@@ -19,7 +23,7 @@ public:
     static void clearLine();
     static void hideCursor();
     static void showCursor();
-    static void printWelcome();
+    static void printWelcome(const std::string& endpoint);
     static void printControls();
     static char getKeyPress();
     static bool isKeyPressed();
@@ -29,40 +33,62 @@ public:
 class OPCUAApplication {
 private:
     OPCUAClient client;
-    MultimeterDevice multimeter;
-    MachineDevice machine;
-    ComputerDevice computer;
+    DeviceRegistry devices;
     
     OPCUANode objectsFolder;
     bool nodesFound;
+    bool autoDiscover{false};
+    size_t pipelineDepth{0};
+    size_t poolSize{0};
+    uint64_t resolvedNamespaceGeneration{0};
     std::atomic<bool> running;
     std::atomic<bool> connectionLost;
     
     
+    std::unique_ptr<OPCUAClientPool> pool;
     std::unique_ptr<AsyncDataManager> asyncManager;
+    std::unique_ptr<ReplaySource> replay;
+    std::unique_ptr<TagStore> store;
+    std::unique_ptr<ServerRegistry> servers;
+    std::vector<uint32_t> serverIds;
     int displayIntervalMs;  
-    
-    
-    int reconnectAttempts;
-    const int maxReconnectAttempts = 10;
+
+    std::vector<std::string> tagLines;
+    uint64_t shownSequence{0};
 
 public:
-    OPCUAApplication(const std::string& endpoint = "opc.tcp://127.0.0.1:4840");
+    OPCUAApplication(const std::string& endpoint = "opc.tcp://127.0.0.1:4840",
+                     const DeviceSchema& schema = DeviceSchema::builtin());
     ~OPCUAApplication();
     
     bool initialize();
-    bool reconnect();  
+    bool initializeReplay(const std::string& directory, double speed, bool loop);
+    // Several servers with the same schema, polled by a ServerRegistry; the
+    // screen shows every server's tags from the shared TagStore. Pairs are
+    // (name, url).
+    bool initializeServers(const std::vector<std::pair<std::string, std::string>>& endpoints);
     void run();
     void shutdown();
     
     bool checkConnection();  
+    void setAutoDiscover(bool enabled) { autoDiscover = enabled; }
+    void setPipelineDepth(size_t depth) { pipelineDepth = depth; }
+    // With a pool, values are read and setpoints written over its sessions;
+    // the main session only resolves nodes and reports the connection.
+    void setPoolSize(size_t sessions) { poolSize = sessions; }
 
 private:
     void handleInput();
     void handleRPMInput();
     void handleControlModeInput();  
+    bool writeTag(size_t tag, double value, QueuedWriteCallback callback);
+    bool resolveDevices();
+    void startAcquisition();
+    void reresolveDevices();
     void readAndDisplayValues();
     void displayAllDevicesAsync(const DeviceData& data);
+    void displayServers();
+    void formatTagLine(const DeviceData& data, size_t tag);
     void displayConnectionStatus();  
 };
 
@@ -1,223 +1,333 @@
 #include "device_managers.h"
+#include "node_cache.h"
+#include <algorithm>
 #include <iostream>
 
 
 
-MultimeterDevice::MultimeterDevice() {}
-
-bool MultimeterDevice::initialize(OPCUAClient& client, const OPCUANode& parentNode) {
-    deviceNode = client.findNodeByBrowseName(parentNode, "Multimeter");
-    if (!deviceNode.isValid()) {
-        return false;
+Device::Device(uint32_t index, const DeviceDescriptor& descriptor, size_t firstTag)
+    : index(index), name(descriptor.name), displayName(descriptor.displayName),
+      firstTag(firstTag), tagCount(descriptor.tags.size()) {}
+
+
+
+DeviceRegistry::DeviceRegistry(const DeviceSchema& schema) {
+    size_t total = schema.tagCount();
+    tags.paths.reserve(total);
+    tags.names.reserve(total);
+    tags.displayNames.reserve(total);
+    tags.units.reserve(total);
+    tags.types.reserve(total);
+    tags.devices.reserve(total);
+    tags.readable.reserve(total);
+    tags.writable.reserve(total);
+    tags.arrays.reserve(total);
+    tags.nodes.reserve(total);
+    tags.deadbandTypes.reserve(total);
+    tags.deadbands.reserve(total);
+    tags.thresholds.reserve(total);
+    tags.historyDepths.reserve(total);
+    devices.reserve(schema.getDevices().size());
+
+    for (const auto& descriptor : schema.getDevices()) {
+        uint32_t deviceIndex = static_cast<uint32_t>(devices.size());
+        devices.emplace_back(deviceIndex, descriptor, tags.size());
+
+        for (const auto& tag : descriptor.tags) {
+            std::string path = descriptor.name + "/" + tag.name;
+            tagIndex.emplace(path, tags.size());
+            tags.paths.push_back(std::move(path));
+            tags.names.push_back(tag.name);
+            tags.displayNames.push_back(tag.displayName);
+            tags.units.push_back(tag.unit);
+            tags.types.push_back(tag.type);
+            tags.devices.push_back(deviceIndex);
+            tags.readable.push_back(tag.readable);
+            tags.writable.push_back(tag.writable);
+            tags.arrays.push_back(tag.array);
+            tags.nodes.emplace_back();
+            tags.deadbandTypes.push_back(tag.deadbandType);
+            tags.deadbands.push_back(tag.deadband);
+            tags.thresholds.push_back(deadbandThreshold(tag, tags.paths.back()));
+            tags.historyDepths.push_back(tag.historyDepth);
+        }
     }
 
-    auto components = client.findDeviceComponents(deviceNode);
-    
-    for (const auto& component : components) {
-        if (component.getBrowseName() == "Voltage") {
-            voltageNode = component;
-        } else if (component.getBrowseName() == "Current") {
-            currentNode = component;
-        } else if (component.getBrowseName() == "Resistance") {
-            resistanceNode = component;
-        } else if (component.getBrowseName() == "Power") {
-            powerNode = component;
-        }
+    for (size_t i = 0; i < BUILTIN_TAG_COUNT; i++) {
+        builtinRows[i] = findTag(std::string(BUILTIN_TAGS[i].device) + "/" + std::string(BUILTIN_TAGS[i].name));
     }
+}
 
-    if (voltageNode.isValid()) allNodes.push_back(voltageNode);
-    if (currentNode.isValid()) allNodes.push_back(currentNode);
-    if (resistanceNode.isValid()) allNodes.push_back(resistanceNode);
-    if (powerNode.isValid()) allNodes.push_back(powerNode);
+double DeviceRegistry::deadbandThreshold(const TagDescriptor& tag, const std::string& path) {
+    switch (tag.deadbandType) {
+    case UA_DEADBANDTYPE_ABSOLUTE:
+        return tag.deadband;
+    case UA_DEADBANDTYPE_PERCENT:
+        if (tag.rangeHigh > tag.rangeLow) return tag.deadband / 100.0 * (tag.rangeHigh - tag.rangeLow);
+        std::cerr << path << ": percent deadband without a range, filtering on any change" << std::endl;
+        return 0.0;
+    default:
+        return 0.0;
+    }
+}
 
-    return voltageNode.isValid() || currentNode.isValid() || 
-           resistanceNode.isValid() || powerNode.isValid();
+const Device* DeviceRegistry::findDevice(const std::string& name) const {
+    for (const auto& device : devices) {
+        if (device.name == name) return &device;
+    }
+    return nullptr;
 }
 
-bool MultimeterDevice::readValues(OPCUAClient& client, double& voltage, double& current, 
-                                  double& resistance, double& power) const {
-    bool voltageOk = client.readValue(voltageNode, voltage);
-    bool currentOk = client.readValue(currentNode, current);
-    bool resistanceOk = client.readValue(resistanceNode, resistance);
-    bool powerOk = client.readValue(powerNode, power);
-    
-    return voltageOk || currentOk || resistanceOk || powerOk;
+size_t DeviceRegistry::findTag(const std::string& path) const {
+    auto it = tagIndex.find(path);
+    return it != tagIndex.end() ? it->second : npos;
 }
 
-std::vector<std::pair<bool, double>> MultimeterDevice::readAllValues(OPCUAClient& client) const {
-    return client.readMultipleValues(allNodes);
+std::vector<OPCUANode> DeviceRegistry::readableNodes() const {
+    std::vector<OPCUANode> nodes;
+    for (size_t i = 0; i < tags.size(); i++) {
+        if (tags.readable[i] && tags.nodes[i].isValid()) nodes.push_back(tags.nodes[i]);
+    }
+    return nodes;
 }
 
-void MultimeterDevice::printStatus() const {
-    std::cout << "Мультиметр: ";
-    if (voltageNode.isValid()) std::cout << "Напряжение доступно, ";
-    if (currentNode.isValid()) std::cout << "Ток доступен, ";
-    if (resistanceNode.isValid()) std::cout << "Сопротивление доступно, ";
-    if (powerNode.isValid()) std::cout << "Мощность доступна";
-    std::cout << std::endl;
+bool DeviceRegistry::anyResolved() const {
+    return std::any_of(tags.nodes.begin(), tags.nodes.end(), [](const OPCUANode& n) { return n.isValid(); });
 }
 
-const OPCUANode& MultimeterDevice::getDeviceNode() const { return deviceNode; }
-const OPCUANode& MultimeterDevice::getVoltageNode() const { return voltageNode; }
-const OPCUANode& MultimeterDevice::getCurrentNode() const { return currentNode; }
-const OPCUANode& MultimeterDevice::getResistanceNode() const { return resistanceNode; }
-const OPCUANode& MultimeterDevice::getPowerNode() const { return powerNode; }
-const std::vector<OPCUANode>& MultimeterDevice::getAllNodes() const { return allNodes; }
+void DeviceRegistry::clearNodes() {
+    for (auto& device : devices) device.deviceNode = OPCUANode();
+    for (auto& node : tags.nodes) node = OPCUANode();
+}
 
+bool DeviceRegistry::prefetch(OPCUAClient& client, const OPCUANode& parentNode) const {
+    if (!client.browseNodes({parentNode})) return false;
 
+    std::vector<OPCUANode> deviceNodes;
+    for (const auto& device : devices) {
+        OPCUANode node = client.findNodeByBrowseName(parentNode, device.name);
+        if (node.isValid()) deviceNodes.push_back(node);
+    }
 
-MachineDevice::MachineDevice() {}
+    return client.browseNodes(deviceNodes);
+}
 
-bool MachineDevice::initialize(OPCUAClient& client, const OPCUANode& parentNode) {
-    deviceNode = client.findNodeByBrowseName(parentNode, "Machine");
-    if (!deviceNode.isValid()) {
-        return false;
+std::vector<std::string> DeviceRegistry::browsePaths() const {
+    std::vector<std::string> paths;
+    paths.reserve(devices.size() + tags.size());
+    for (const auto& device : devices) {
+        paths.push_back(device.name);
+        for (size_t t = device.firstTag; t < device.getEndTag(); t++) {
+            paths.push_back(tags.paths[t]);
+        }
     }
+    return paths;
+}
 
-    auto components = client.findDeviceComponents(deviceNode);
-    
-    for (const auto& component : components) {
-        if (component.getBrowseName() == "FlywheelRPM") {
-            flywheelRPMNode = component;
-        } else if (component.getBrowseName() == "Power") {
-            powerNode = component;
-        } else if (component.getBrowseName() == "Voltage") {
-            voltageNode = component;
-        } else if (component.getBrowseName() == "EnergyConsumption") {
-            energyConsumptionNode = component;
-        } else if (component.getBrowseName() == "TargetRPM") {
-            targetRPMNode = component;
-        } else if (component.getBrowseName() == "RPMControlMode") {
-            rpmControlModeNode = component;
+void DeviceRegistry::assign(const std::vector<OPCUANode>& resolved) {
+    size_t index = 0;
+    for (auto& device : devices) {
+        device.deviceNode = resolved[index++];
+        for (size_t t = device.firstTag; t < device.getEndTag(); t++, index++) {
+            tags.nodes[t] = device.deviceNode.isValid() ? resolved[index] : OPCUANode();
         }
     }
+}
 
-    if (flywheelRPMNode.isValid()) allNodes.push_back(flywheelRPMNode);
-    if (powerNode.isValid()) allNodes.push_back(powerNode);
-    if (voltageNode.isValid()) allNodes.push_back(voltageNode);
-    if (energyConsumptionNode.isValid()) allNodes.push_back(energyConsumptionNode);
+bool DeviceRegistry::resolve(OPCUAClient& client, const OPCUANode& parentNode, const std::string& cachePath) {
+    std::vector<std::string> paths = browsePaths();
+
+    NodeIdCache cache;
+    bool cached = !cachePath.empty() && cache.load(cachePath) &&
+                  cache.matches(client.getEndpoint(), client.getNamespaceArray());
+
+    std::vector<OPCUANode> resolved(paths.size());
+    UA_UInt16 browseNamespace = cache.getBrowseNamespace();
+    bool cacheUpdated = false;
+    if (cached) {
+        // Paths added to the schema since the cache was written are not in
+        // it; translate just those and merge them in.
+        std::vector<size_t> missing;
+        std::vector<std::string> missingPaths;
+        for (size_t i = 0; i < paths.size(); i++) {
+            resolved[i] = cache.find(paths[i]);
+            if (!resolved[i].isValid()) {
+                missing.push_back(i);
+                missingPaths.push_back(paths[i]);
+            }
+        }
+        if (!missing.empty()) {
+            std::vector<OPCUANode> translated = client.translateBrowsePaths(parentNode, missingPaths, browseNamespace);
+            for (size_t m = 0; m < missing.size() && m < translated.size(); m++) {
+                if (!translated[m].isValid()) continue;
+                resolved[missing[m]] = translated[m];
+                cache.set(missingPaths[m], translated[m]);
+                cacheUpdated = true;
+            }
+        }
+    } else {
+        resolved = client.translateBrowsePaths(parentNode, paths, browseNamespace);
+
+        bool anyFound = std::any_of(resolved.begin(), resolved.end(),
+                                    [](const OPCUANode& n) { return n.isValid(); });
+        if (!anyFound) {
+            prefetch(client, parentNode);
+            std::vector<BrowseReference> roots = client.getReferences(parentNode);
+            bool namespaceFound = false;
+            size_t index = 0;
+            for (const auto& device : devices) {
+                OPCUANode deviceNode;
+                for (const auto& ref : roots) {
+                    if (ref.node.getBrowseName() != device.name) continue;
+                    deviceNode = ref.node;
+                    if (!namespaceFound) browseNamespace = ref.browseNamespace;
+                    namespaceFound = true;
+                    break;
+                }
+                resolved[index++] = deviceNode;
+                auto components = client.findDeviceComponents(deviceNode);
+                for (size_t t = device.firstTag; t < device.getEndTag(); t++, index++) {
+                    for (const auto& component : components) {
+                        if (component.getBrowseName() == tags.names[t]) resolved[index] = component;
+                    }
+                }
+            }
+        }
+    }
 
-    return flywheelRPMNode.isValid() || powerNode.isValid() || 
-           voltageNode.isValid() || energyConsumptionNode.isValid() ||
-           targetRPMNode.isValid() || rpmControlModeNode.isValid();
-}
+    assign(resolved);
+    bool found = anyResolved();
 
-bool MachineDevice::readValues(OPCUAClient& client, double& rpm, double& power, 
-                               double& voltage, double& energy) const {
-    bool rpmOk = client.readValue(flywheelRPMNode, rpm);
-    bool powerOk = client.readValue(powerNode, power);
-    bool voltageOk = client.readValue(voltageNode, voltage);
-    bool energyOk = client.readValue(energyConsumptionNode, energy);
-    
-    return rpmOk || powerOk || voltageOk || energyOk;
-}
+    if (!cached && !cachePath.empty() && found) {
+        cache.reset(client.getEndpoint(), client.getNamespaceArray());
+        cache.setBrowseNamespace(browseNamespace);
+        for (size_t i = 0; i < paths.size(); i++) {
+            cache.set(paths[i], resolved[i]);
+        }
+        cache.save(cachePath);
+    } else if (cacheUpdated) {
+        cache.save(cachePath);
+    }
 
-std::vector<std::pair<bool, double>> MachineDevice::readAllValues(OPCUAClient& client) const {
-    return client.readMultipleValues(allNodes);
+    return found;
 }
 
-bool MachineDevice::setTargetRPM(OPCUAClient& client, double rpm) {
-    if (!targetRPMNode.isValid()) {
-        std::cerr << "TargetRPM node not found" << std::endl;
-        return false;
+// Replaces the schema with whatever the server exposes: every Object directly
+// under parentNode becomes a device, and every numeric Variable below it
+// becomes a tag named by its browse path inside that device. Type, shape and
+// access come from one batched Read of the variables' attributes.
+bool DeviceRegistry::discover(OPCUAClient& client, const OPCUANode& parentNode, const DiscoveryOptions& options) {
+    std::vector<DiscoveredNode> found;
+    if (!client.discover(parentNode, found, options)) {
+        std::cerr << "Discovery incomplete, using " << found.size() << " nodes found so far" << std::endl;
     }
-    return client.writeValue(targetRPMNode, rpm);
-}
 
-bool MachineDevice::setControlMode(OPCUAClient& client, int mode) {
-    if (!rpmControlModeNode.isValid()) {
-        std::cerr << "RPMControlMode node not found" << std::endl;
-        return false;
+    std::vector<uint32_t> top(found.size());
+    std::vector<size_t> deviceOf(found.size(), npos);
+    std::vector<uint32_t> deviceNodes;
+    for (size_t i = 0; i < found.size(); i++) {
+        bool isRoot = found[i].parent == DiscoveredNode::ROOT;
+        top[i] = isRoot ? static_cast<uint32_t>(i) : top[found[i].parent];
+        if (isRoot && found[i].nodeClass == UA_NODECLASS_OBJECT) {
+            deviceOf[i] = deviceNodes.size();
+            deviceNodes.push_back(static_cast<uint32_t>(i));
+        }
     }
-    double modeValue = static_cast<double>(mode);
-    return client.writeValue(rpmControlModeNode, modeValue);
-}
 
-void MachineDevice::printStatus() const {
-    std::cout << "Станок: ";
-    if (flywheelRPMNode.isValid()) std::cout << "Обороты доступны, ";
-    if (powerNode.isValid()) std::cout << "Мощность доступна, ";
-    if (voltageNode.isValid()) std::cout << "Напряжение доступно, ";
-    if (energyConsumptionNode.isValid()) std::cout << "Энергопотребление доступно, ";
-    if (targetRPMNode.isValid()) std::cout << "Целевые обороты доступны (для записи), ";
-    if (rpmControlModeNode.isValid()) std::cout << "Режим управления доступен (для записи)";
-    std::cout << std::endl;
-}
+    std::vector<std::vector<uint32_t>> members(deviceNodes.size());
+    for (size_t i = 0; i < found.size(); i++) {
+        size_t device = deviceOf[top[i]];
+        if (device != npos && found[i].nodeClass == UA_NODECLASS_VARIABLE) {
+            members[device].push_back(static_cast<uint32_t>(i));
+        }
+    }
 
-const OPCUANode& MachineDevice::getDeviceNode() const { return deviceNode; }
-const OPCUANode& MachineDevice::getFlywheelRPMNode() const { return flywheelRPMNode; }
-const OPCUANode& MachineDevice::getPowerNode() const { return powerNode; }
-const OPCUANode& MachineDevice::getVoltageNode() const { return voltageNode; }
-const OPCUANode& MachineDevice::getEnergyConsumptionNode() const { return energyConsumptionNode; }
-const OPCUANode& MachineDevice::getTargetRPMNode() const { return targetRPMNode; }
-const OPCUANode& MachineDevice::getControlModeNode() const { return rpmControlModeNode; }
-const std::vector<OPCUANode>& MachineDevice::getAllNodes() const { return allNodes; }
+    std::vector<OPCUANode> variables;
+    std::vector<uint32_t> variableOf(found.size(), UINT32_MAX);
+    for (const auto& device : members) {
+        for (uint32_t m : device) {
+            variableOf[m] = static_cast<uint32_t>(variables.size());
+            variables.push_back(found[m].node);
+        }
+    }
+    std::vector<VariableAttributes> attributes;
+    if (!client.readVariableAttributes(variables, attributes)) {
+        std::cerr << "Could not read attributes of every discovered variable, skipping the rest" << std::endl;
+    }
 
+    size_t skipped = 0;
+    DeviceSchema schema;
+    std::vector<OPCUANode> resolved;
+    for (size_t d = 0; d < deviceNodes.size(); d++) {
+        const DiscoveredNode& deviceNode = found[deviceNodes[d]];
+        DeviceDescriptor descriptor{deviceNode.node.getBrowseName(), deviceNode.node.getDisplayName(), {}};
+        std::vector<OPCUANode> tagNodes;
+
+        for (uint32_t m : members[d]) {
+            const VariableAttributes& attr = attributes[variableOf[m]];
+            if (!attr.type) {
+                skipped++;
+                continue;
+            }
+            const DiscoveredNode& tagNode = found[m];
+            std::string name = tagNode.path.substr(deviceNode.path.size() + 1);
+            // ValueRank 0 and above means one or more dimensions; -2 (any) and
+            // -3 (scalar or 1-D) are read as scalars.
+            descriptor.tags.push_back({name, tagNode.node.getDisplayName(), "", attr.type,
+                                       (attr.accessLevel & UA_ACCESSLEVELMASK_READ) != 0,
+                                       (attr.accessLevel & UA_ACCESSLEVELMASK_WRITE) != 0,
+                                       attr.valueRank >= 0});
+            tagNodes.push_back(tagNode.node);
+        }
+        if (descriptor.tags.empty()) continue;
 
+        resolved.push_back(deviceNode.node);
+        resolved.insert(resolved.end(), tagNodes.begin(), tagNodes.end());
+        schema.addDevice(std::move(descriptor));
+    }
+    if (skipped > 0) {
+        std::cerr << "Skipped " << skipped << " discovered variables without a numeric data type" << std::endl;
+    }
 
-ComputerDevice::ComputerDevice() {}
+    *this = DeviceRegistry(schema);
+    assign(resolved);
+    return anyResolved();
+}
 
-bool ComputerDevice::initialize(OPCUAClient& client, const OPCUANode& parentNode) {
-    deviceNode = client.findNodeByBrowseName(parentNode, "Computer");
-    if (!deviceNode.isValid()) {
+bool DeviceRegistry::checkWritable(size_t tag) const {
+    if (tag >= tags.size() || !tags.writable[tag]) {
+        std::cerr << "Tag is not writable" << std::endl;
         return false;
     }
-
-    auto components = client.findDeviceComponents(deviceNode);
-    
-    for (const auto& component : components) {
-        if (component.getBrowseName() == "Fan1") {
-            fan1Node = component;
-        } else if (component.getBrowseName() == "Fan2") {
-            fan2Node = component;
-        } else if (component.getBrowseName() == "Fan3") {
-            fan3Node = component;
-        } else if (component.getBrowseName() == "CPULoad") {
-            cpuLoadNode = component;
-        } else if (component.getBrowseName() == "GPULoad") {
-            gpuLoadNode = component;
-        } else if (component.getBrowseName() == "RAMUsage") {
-            ramUsageNode = component;
-        }
+    if (!tags.nodes[tag].isValid()) {
+        std::cerr << tags.paths[tag] << " node not found" << std::endl;
+        return false;
     }
-
-    if (fan1Node.isValid()) allNodes.push_back(fan1Node);
-    if (fan2Node.isValid()) allNodes.push_back(fan2Node);
-    if (fan3Node.isValid()) allNodes.push_back(fan3Node);
-    if (cpuLoadNode.isValid()) allNodes.push_back(cpuLoadNode);
-    if (gpuLoadNode.isValid()) allNodes.push_back(gpuLoadNode);
-    if (ramUsageNode.isValid()) allNodes.push_back(ramUsageNode);
-
-    return fan1Node.isValid() || fan2Node.isValid() || fan3Node.isValid() ||
-           cpuLoadNode.isValid() || gpuLoadNode.isValid() || ramUsageNode.isValid();
+    return true;
 }
 
-bool ComputerDevice::readValues(OPCUAClient& client, double& fan1, double& fan2, double& fan3,
-                                double& cpuLoad, double& gpuLoad, double& ramUsage) const {
-    bool fan1Ok = client.readValue(fan1Node, fan1);
-    bool fan2Ok = client.readValue(fan2Node, fan2);
-    bool fan3Ok = client.readValue(fan3Node, fan3);
-    bool cpuOk = client.readValue(cpuLoadNode, cpuLoad);
-    bool gpuOk = client.readValue(gpuLoadNode, gpuLoad);
-    bool ramOk = client.readValue(ramUsageNode, ramUsage);
-    
-    return fan1Ok || fan2Ok || fan3Ok || cpuOk || gpuOk || ramOk;
+bool DeviceRegistry::write(OPCUAClient& client, size_t tag, double value, QueuedWriteCallback callback) const {
+    if (!checkWritable(tag)) return false;
+    return client.queueWrite(tags.nodes[tag], value, std::move(callback), tags.types[tag]);
 }
 
-std::vector<std::pair<bool, double>> ComputerDevice::readAllValues(OPCUAClient& client) const {
-    return client.readMultipleValues(allNodes);
+bool DeviceRegistry::write(OPCUAClientPool& pool, size_t tag, double value, QueuedWriteCallback callback) const {
+    if (!checkWritable(tag)) return false;
+    return pool.queueWrite(tags.nodes[tag], value, std::move(callback), tags.types[tag]);
 }
 
-void ComputerDevice::printStatus() const {
-    std::cout << "Компьютер: ";
-    if (fan1Node.isValid()) std::cout << "Вентилятор1 доступен, ";
-    if (fan2Node.isValid()) std::cout << "Вентилятор2 доступен, ";
-    if (fan3Node.isValid()) std::cout << "Вентилятор3 доступен, ";
-    if (cpuLoadNode.isValid()) std::cout << "ЦП доступен, ";
-    if (gpuLoadNode.isValid()) std::cout << "ГП доступен, ";
-    if (ramUsageNode.isValid()) std::cout << "ОЗУ доступно";
-    std::cout << std::endl;
+void DeviceRegistry::printStatus() const {
+    for (const auto& device : devices) {
+        if (!device.isResolved()) continue;
+
+        std::cout << device.displayName << ": ";
+        bool first = true;
+        for (size_t t = device.firstTag; t < device.getEndTag(); t++) {
+            if (!tags.nodes[t].isValid()) continue;
+            std::cout << (first ? "" : ", ") << tags.displayNames[t];
+            if (tags.writable[t]) std::cout << " (для записи)";
+            first = false;
+        }
+        std::cout << std::endl;
+    }
 }
-
-const OPCUANode& ComputerDevice::getDeviceNode() const { return deviceNode; }
-const std::vector<OPCUANode>& ComputerDevice::getAllNodes() const { return allNodes; }
\ No newline at end of file
@@ -2,90 +2,109 @@
 #define DEVICE_MANAGERS_H
 
 #include "opcua_client.h"
-#include <vector>
+#include "client_pool.h"
+#include "device_schema.h"
+#include <array>
+#include <cstdint>
 #include <string>
-#include <utility>
+#include <unordered_map>
+#include <vector>
 
 
-class MultimeterDevice {
-private:
-    OPCUANode deviceNode;
-    OPCUANode voltageNode;
-    OPCUANode currentNode;
-    OPCUANode resistanceNode;
-    OPCUANode powerNode;
-    std::vector<OPCUANode> allNodes;
+// One row per tag of every device, devices back to back in schema order.
+// Acquisition, the published snapshot and the UIs all address tags by row.
+struct TagTable {
+    std::vector<std::string> paths;
+    std::vector<std::string> names;
+    std::vector<std::string> displayNames;
+    std::vector<std::string> units;
+    std::vector<const UA_DataType*> types;
+    std::vector<uint32_t> devices;
+    std::vector<uint8_t> readable;
+    std::vector<uint8_t> writable;
+    std::vector<uint8_t> arrays;
+    std::vector<OPCUANode> nodes;
 
-public:
-    MultimeterDevice();
-    bool initialize(OPCUAClient& client, const OPCUANode& parentNode);
-    bool readValues(OPCUAClient& client, double& voltage, double& current, 
-                    double& resistance, double& power) const;
-    std::vector<std::pair<bool, double>> readAllValues(OPCUAClient& client) const;
-    void printStatus() const;
-    
-    const OPCUANode& getDeviceNode() const;
-    const OPCUANode& getVoltageNode() const;
-    const OPCUANode& getCurrentNode() const;
-    const OPCUANode& getResistanceNode() const;
-    const OPCUANode& getPowerNode() const;
-    const std::vector<OPCUANode>& getAllNodes() const;
+    // Deadband as configured, handed to the server in subscriptions, and the
+    // absolute threshold the client applies itself; 0 means any change.
+    std::vector<UA_DeadbandType> deadbandTypes;
+    std::vector<double> deadbands;
+    std::vector<double> thresholds;
+
+    // TagDescriptor::historyDepth, 0 for the acquisition default.
+    std::vector<uint32_t> historyDepths;
+
+    size_t size() const { return paths.size(); }
 };
 
 
-class MachineDevice {
+class Device {
 private:
+    uint32_t index;
+    std::string name;
+    std::string displayName;
+    size_t firstTag;
+    size_t tagCount;
     OPCUANode deviceNode;
-    OPCUANode flywheelRPMNode;
-    OPCUANode powerNode;
-    OPCUANode voltageNode;
-    OPCUANode energyConsumptionNode;
-    OPCUANode targetRPMNode;          
-    OPCUANode rpmControlModeNode;     
-    std::vector<OPCUANode> allNodes;
+
+    friend class DeviceRegistry;
 
 public:
-    MachineDevice();
-    bool initialize(OPCUAClient& client, const OPCUANode& parentNode);
-    bool readValues(OPCUAClient& client, double& rpm, double& power, 
-                    double& voltage, double& energy) const;
-    std::vector<std::pair<bool, double>> readAllValues(OPCUAClient& client) const;
-    bool setTargetRPM(OPCUAClient& client, double rpm);  
-    bool setControlMode(OPCUAClient& client, int mode);  
-    void printStatus() const;
-    
-    const OPCUANode& getDeviceNode() const;
-    const OPCUANode& getFlywheelRPMNode() const;
-    const OPCUANode& getPowerNode() const;
-    const OPCUANode& getVoltageNode() const;
-    const OPCUANode& getEnergyConsumptionNode() const;
-    const OPCUANode& getTargetRPMNode() const;      
-    const OPCUANode& getControlModeNode() const;    
-    const std::vector<OPCUANode>& getAllNodes() const;
+    Device(uint32_t index, const DeviceDescriptor& descriptor, size_t firstTag);
+
+    uint32_t getIndex() const { return index; }
+    const std::string& getName() const { return name; }
+    const std::string& getDisplayName() const { return displayName; }
+    size_t getFirstTag() const { return firstTag; }
+    size_t getEndTag() const { return firstTag + tagCount; }
+    size_t getTagCount() const { return tagCount; }
+    const OPCUANode& getDeviceNode() const { return deviceNode; }
+    bool isResolved() const { return deviceNode.isValid(); }
 };
 
 
-class ComputerDevice {
+class DeviceRegistry {
 private:
-    OPCUANode deviceNode;
-    OPCUANode fan1Node;
-    OPCUANode fan2Node;
-    OPCUANode fan3Node;
-    OPCUANode cpuLoadNode;
-    OPCUANode gpuLoadNode;
-    OPCUANode ramUsageNode;
-    std::vector<OPCUANode> allNodes;
+    std::vector<Device> devices;
+    TagTable tags;
+    std::unordered_map<std::string, size_t> tagIndex;
+    std::array<size_t, BUILTIN_TAG_COUNT> builtinRows;
+
+    std::vector<std::string> browsePaths() const;
+    static double deadbandThreshold(const TagDescriptor& tag, const std::string& path);
+    void assign(const std::vector<OPCUANode>& resolved);
+    bool checkWritable(size_t tag) const;
 
 public:
-    ComputerDevice();
-    bool initialize(OPCUAClient& client, const OPCUANode& parentNode);
-    bool readValues(OPCUAClient& client, double& fan1, double& fan2, double& fan3,
-                    double& cpuLoad, double& gpuLoad, double& ramUsage) const;
-    std::vector<std::pair<bool, double>> readAllValues(OPCUAClient& client) const;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit DeviceRegistry(const DeviceSchema& schema = DeviceSchema::builtin());
+
+    bool prefetch(OPCUAClient& client, const OPCUANode& parentNode) const;
+    bool resolve(OPCUAClient& client, const OPCUANode& parentNode,
+                 const std::string& cachePath = "nodeid_cache.txt");
+    bool discover(OPCUAClient& client, const OPCUANode& parentNode,
+                  const DiscoveryOptions& options = DiscoveryOptions());
+    void clearNodes();
+
+    const std::vector<Device>& getDevices() const { return devices; }
+    const Device* findDevice(const std::string& name) const;
+    size_t deviceCount() const { return devices.size(); }
+
+    const TagTable& getTags() const { return tags; }
+    size_t findTag(const std::string& path) const;
+    // Row of a BuiltinTags entry; the identity for the builtin schema, npos
+    // when a loaded or discovered schema lacks that tag.
+    size_t builtinRow(size_t builtinTag) const {
+        return builtinTag < BUILTIN_TAG_COUNT ? builtinRows[builtinTag] : npos;
+    }
+    size_t tagCount() const { return tags.size(); }
+    std::vector<OPCUANode> readableNodes() const;
+    bool anyResolved() const;
+
+    bool write(OPCUAClient& client, size_t tag, double value, QueuedWriteCallback callback = nullptr) const;
+    bool write(OPCUAClientPool& pool, size_t tag, double value, QueuedWriteCallback callback = nullptr) const;
     void printStatus() const;
-    
-    const OPCUANode& getDeviceNode() const;
-    const std::vector<OPCUANode>& getAllNodes() const;
 };
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,148 @@
+#include "device_schema.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+
+bool DeviceSchema::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to open device schema " << path << std::endl;
+        return false;
+    }
+
+    devices.clear();
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 2) continue;
+
+        const std::string& kind = fields[0];
+        if (kind == "device") {
+            DeviceDescriptor device;
+            device.name = fields[1];
+            device.displayName = fields.size() >= 3 ? fields[2] : fields[1];
+            devices.push_back(std::move(device));
+        } else if (kind == "tag") {
+            if (devices.empty()) {
+                std::cerr << "Tag before any device in " << path << ": " << line << std::endl;
+                continue;
+            }
+
+            TagDescriptor tag;
+            tag.name = fields[1];
+            std::string typeName = fields.size() >= 3 ? fields[2] : "Double";
+            if (typeName.size() > 2 && typeName.compare(typeName.size() - 2, 2, "[]") == 0) {
+                tag.array = true;
+                typeName.resize(typeName.size() - 2);
+            }
+            tag.type = typeFromName(typeName);
+            if (!tag.type) {
+                std::cerr << "Unsupported tag type in " << path << ": " << line << std::endl;
+                continue;
+            }
+
+            std::string access = fields.size() >= 4 ? fields[3] : "r";
+            tag.readable = access.find('r') != std::string::npos;
+            tag.writable = access.find('w') != std::string::npos;
+            tag.displayName = fields.size() >= 5 ? fields[4] : tag.name;
+            tag.unit = fields.size() >= 6 ? fields[5] : std::string();
+            if ((fields.size() >= 7 && !parseDeadband(fields[6], tag)) ||
+                (fields.size() >= 8 && !parseRange(fields[7], tag)) ||
+                (fields.size() >= 9 && !parseHistoryDepth(fields[8], tag))) {
+                std::cerr << "Invalid deadband, range or history depth in " << path << ": " << line << std::endl;
+                continue;
+            }
+            devices.back().tags.push_back(std::move(tag));
+        }
+    }
+
+    return !devices.empty();
+}
+
+size_t DeviceSchema::tagCount() const {
+    size_t count = 0;
+    for (const auto& device : devices) {
+        count += device.tags.size();
+    }
+    return count;
+}
+
+const UA_DataType* DeviceSchema::typeFromName(const std::string& name) {
+    static const std::pair<const char*, int> types[] = {
+        {"Boolean", UA_TYPES_BOOLEAN}, {"SByte", UA_TYPES_SBYTE}, {"Byte", UA_TYPES_BYTE},
+        {"Int16", UA_TYPES_INT16}, {"UInt16", UA_TYPES_UINT16}, {"Int32", UA_TYPES_INT32},
+        {"UInt32", UA_TYPES_UINT32}, {"Int64", UA_TYPES_INT64}, {"UInt64", UA_TYPES_UINT64},
+        {"Float", UA_TYPES_FLOAT}, {"Double", UA_TYPES_DOUBLE},
+    };
+
+    for (const auto& [typeName, index] : types) {
+        if (name == typeName) return &UA_TYPES[index];
+    }
+    return nullptr;
+}
+
+bool DeviceSchema::parseDeadband(const std::string& text, TagDescriptor& tag) {
+    if (text.empty()) return true;
+
+    bool percent = text.back() == '%';
+    std::istringstream stream(percent ? text.substr(0, text.size() - 1) : text);
+    double value = 0.0;
+    if (!(stream >> value) || !stream.eof() || value < 0.0 || (percent && value > 100.0)) return false;
+
+    tag.deadbandType = value == 0.0 ? UA_DEADBANDTYPE_NONE
+                     : percent ? UA_DEADBANDTYPE_PERCENT : UA_DEADBANDTYPE_ABSOLUTE;
+    tag.deadband = value;
+    return true;
+}
+
+bool DeviceSchema::parseRange(const std::string& text, TagDescriptor& tag) {
+    if (text.empty()) return true;
+
+    std::istringstream stream(text);
+    double low = 0.0, high = 0.0;
+    char separator = 0;
+    if (!(stream >> low >> separator >> high) || separator != ':' || !(high > low)) return false;
+
+    tag.rangeLow = low;
+    tag.rangeHigh = high;
+    return true;
+}
+
+bool DeviceSchema::parseHistoryDepth(const std::string& text, TagDescriptor& tag) {
+    if (text.empty()) return true;
+
+    std::istringstream stream(text);
+    uint32_t depth = 0;
+    if (!(stream >> depth) || !stream.eof() || depth == 0) return false;
+
+    tag.historyDepth = depth;
+    return true;
+}
+
+// The simulator's tags are the ones the UIs plot, so they keep a deep history.
+DeviceSchema DeviceSchema::builtin() {
+    const UA_DataType* dbl = &UA_TYPES[UA_TYPES_DOUBLE];
+
+    DeviceSchema schema;
+    for (const auto& device : BUILTIN_DEVICES) {
+        DeviceDescriptor descriptor{std::string(device.name), std::string(device.displayName), {}};
+        for (const auto& tag : BUILTIN_TAGS) {
+            if (tag.device != device.name) continue;
+            descriptor.tags.push_back({std::string(tag.name), std::string(tag.displayName),
+                                       std::string(tag.unit), dbl, tag.readable, tag.writable});
+            descriptor.tags.back().historyDepth = BUILTIN_HISTORY_DEPTH;
+        }
+        schema.addDevice(std::move(descriptor));
+    }
+    return schema;
+}
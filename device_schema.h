@@ -0,0 +1,150 @@
+#ifndef DEVICE_SCHEMA_H
+#define DEVICE_SCHEMA_H
+
+#include <open62541/types.h>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+struct TagDescriptor {
+    std::string name;
+    std::string displayName;
+    std::string unit;
+    const UA_DataType* type{nullptr};
+    bool readable{true};
+    bool writable{false};
+    bool array{false};
+
+    // Percent deadbands are relative to rangeHigh - rangeLow (the EURange).
+    UA_DeadbandType deadbandType{UA_DEADBANDTYPE_NONE};
+    double deadband{0.0};
+    double rangeLow{0.0};
+    double rangeHigh{0.0};
+
+    // Samples kept in the tag's TagHistory; 0 takes the acquisition default.
+    uint32_t historyDepth{0};
+};
+
+struct DeviceDescriptor {
+    std::string name;
+    std::string displayName;
+    std::vector<TagDescriptor> tags;
+};
+
+
+// Layout of the bundled simulator, fixed at compile time. A registry built
+// from DeviceSchema::builtin() has its TagTable rows in exactly this order, so
+// the BuiltinTags constants are valid row indices into it.
+struct BuiltinTag {
+    std::string_view device;
+    std::string_view name;
+    std::string_view displayName;
+    std::string_view unit;
+    bool readable;
+    bool writable;
+};
+
+struct BuiltinDevice {
+    std::string_view name;
+    std::string_view displayName;
+};
+
+inline constexpr BuiltinDevice BUILTIN_DEVICES[] = {
+    {"Multimeter", "Мультиметр"},
+    {"Machine", "Станок"},
+    {"Computer", "Компьютер"},
+};
+
+inline constexpr BuiltinTag BUILTIN_TAGS[] = {
+    {"Multimeter", "Voltage", "Напряжение", "В", true, false},
+    {"Multimeter", "Current", "Ток", "А", true, false},
+    {"Multimeter", "Resistance", "Сопротивление", "Ом", true, false},
+    {"Multimeter", "Power", "Мощность", "Вт", true, false},
+    {"Machine", "FlywheelRPM", "Обороты маховика", "об/мин", true, false},
+    {"Machine", "Power", "Мощность", "кВт", true, false},
+    {"Machine", "Voltage", "Напряжение", "В", true, false},
+    {"Machine", "EnergyConsumption", "Потребление энергии", "кВт·ч", true, false},
+    {"Machine", "TargetRPM", "Целевые обороты", "об/мин", false, true},
+    {"Machine", "RPMControlMode", "Режим управления", "", false, true},
+    {"Computer", "Fan1", "Вентилятор 1", "об/мин", true, false},
+    {"Computer", "Fan2", "Вентилятор 2", "об/мин", true, false},
+    {"Computer", "Fan3", "Вентилятор 3", "об/мин", true, false},
+    {"Computer", "CPULoad", "Загрузка ЦП", "%", true, false},
+    {"Computer", "GPULoad", "Загрузка ГП", "%", true, false},
+    {"Computer", "RAMUsage", "Использование ОЗУ", "%", true, false},
+};
+
+inline constexpr size_t BUILTIN_DEVICE_COUNT = std::size(BUILTIN_DEVICES);
+inline constexpr size_t BUILTIN_TAG_COUNT = std::size(BUILTIN_TAGS);
+inline constexpr uint32_t BUILTIN_HISTORY_DEPTH = 4096;
+
+constexpr size_t builtinTagIndex(std::string_view device, std::string_view name) {
+    for (size_t i = 0; i < BUILTIN_TAG_COUNT; i++) {
+        if (BUILTIN_TAGS[i].device == device && BUILTIN_TAGS[i].name == name) return i;
+    }
+    return BUILTIN_TAG_COUNT;
+}
+
+constexpr size_t builtinReadableCount() {
+    size_t count = 0;
+    for (const auto& tag : BUILTIN_TAGS) count += tag.readable ? 1 : 0;
+    return count;
+}
+
+// Tags of one device must be contiguous for the table to map onto TagTable rows.
+constexpr bool builtinTagsGrouped() {
+    size_t device = 0;
+    for (const auto& tag : BUILTIN_TAGS) {
+        while (device < BUILTIN_DEVICE_COUNT && BUILTIN_DEVICES[device].name != tag.device) device++;
+        if (device == BUILTIN_DEVICE_COUNT) return false;
+    }
+    return true;
+}
+static_assert(builtinTagsGrouped(), "BUILTIN_TAGS must follow BUILTIN_DEVICES order");
+
+namespace BuiltinTags {
+    inline constexpr size_t MachineTargetRPM = builtinTagIndex("Machine", "TargetRPM");
+    inline constexpr size_t MachineControlMode = builtinTagIndex("Machine", "RPMControlMode");
+    inline constexpr size_t ReadableCount = builtinReadableCount();
+
+    static_assert(MachineTargetRPM < BUILTIN_TAG_COUNT && MachineControlMode < BUILTIN_TAG_COUNT,
+                  "setpoint tags missing from BUILTIN_TAGS");
+}
+
+
+// Which device objects to look for under Objects and which variables they
+// carry. Loaded from a tab-separated file at startup:
+//
+//   device  Machine    Станок
+//   tag     TargetRPM  Double  rw  Целевые обороты  об/мин
+//   tag     CPULoad    Double  r   Загрузка ЦП      %       0.5%  0:100  4096
+//
+// The optional last three columns are the deadband, absolute ("2.5") or
+// percent of the range ("0.5%"), the range as low:high, and how many samples
+// of history to keep for the tag. A type ending in "[]"
+// ("Double[]") declares a one-dimensional array tag, acquired whole.
+//
+// builtin() is the layout of the bundled simulator.
+class DeviceSchema {
+private:
+    std::vector<DeviceDescriptor> devices;
+
+public:
+    bool load(const std::string& path);
+
+    void addDevice(DeviceDescriptor device) { devices.push_back(std::move(device)); }
+    const std::vector<DeviceDescriptor>& getDevices() const { return devices; }
+    size_t tagCount() const;
+    bool empty() const { return devices.empty(); }
+
+    static DeviceSchema builtin();
+    static const UA_DataType* typeFromName(const std::string& name);
+    static bool parseDeadband(const std::string& text, TagDescriptor& tag);
+    static bool parseRange(const std::string& text, TagDescriptor& tag);
+    static bool parseHistoryDepth(const std::string& text, TagDescriptor& tag);
+};
+
+#endif
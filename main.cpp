@@ -6,6 +6,10 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <string>
+#include <fstream>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -88,8 +92,73 @@ private:
 
 std::atomic<bool> SignalHandler::running(true);
 
-int main() {
+// One server per line: the URL, or a name and the URL separated by a tab.
+static bool loadServerList(const std::string& path, std::vector<std::pair<std::string, std::string>>& servers) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Не удалось открыть список серверов " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            servers.emplace_back(line, line);
+        } else {
+            servers.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
     SignalHandler::initialize();
+
+    std::string replayDirectory;
+    double replaySpeed = 1.0;
+    bool replayLoop = false;
+    std::string endpoint = "opc.tcp://127.0.0.1:4840";
+    std::vector<std::pair<std::string, std::string>> servers;
+    DeviceSchema schema = DeviceSchema::builtin();
+    bool discover = false;
+    size_t pipelineDepth = 0;
+    size_t poolSize = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--endpoint" && i + 1 < argc) {
+            endpoint = argv[++i];
+            servers.emplace_back(endpoint, endpoint);
+        } else if (arg == "--servers" && i + 1 < argc) {
+            if (!loadServerList(argv[++i], servers)) {
+                return 1;
+            }
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayDirectory = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            std::string value = argv[++i];
+            replaySpeed = value == "max" ? 0.0 : std::stod(value);
+        } else if (arg == "--loop") {
+            replayLoop = true;
+        } else if (arg == "--discover") {
+            discover = true;
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            pipelineDepth = std::stoul(argv[++i]);
+        } else if (arg == "--pool" && i + 1 < argc) {
+            poolSize = std::stoul(argv[++i]);
+        } else if (arg == "--devices" && i + 1 < argc) {
+            if (!schema.load(argv[++i])) {
+                return 1;
+            }
+        }
+    }
+    if (servers.size() == 1) {
+        endpoint = servers.front().second;
+    }
     
     std::cout << "===========================================" << std::endl;
     std::cout << "Запуск OPC UA клиента" << std::endl;
@@ -97,16 +166,23 @@ int main() {
     std::cout << "===========================================\n" << std::endl;
     
     try {
-        OPCUAApplication app;
+        OPCUAApplication app(endpoint, schema);
         g_app = &app; 
+        app.setAutoDiscover(discover);
+        app.setPipelineDepth(pipelineDepth);
+        app.setPoolSize(poolSize);
         
-        if (!app.initialize()) {
+        bool initialized = !replayDirectory.empty()
+            ? app.initializeReplay(replayDirectory, replaySpeed, replayLoop)
+            : servers.size() > 1 ? app.initializeServers(servers) : app.initialize();
+
+        if (!initialized) {
             std::cerr << "Ошибка инициализации приложения." << std::endl;
             std::cerr << "Возможные причины:" << std::endl;
             std::cerr << "1. Сервер OPC UA не запущен" << std::endl;
             std::cerr << "2. Неверный адрес сервера" << std::endl;
             std::cerr << "3. Проблемы с сетью" << std::endl;
-            std::cerr << "Проверьте, что сервер запущен по адресу: opc.tcp://127.0.0.1:4840" << std::endl;
+            std::cerr << "Проверьте, что сервер запущен по адресу: " << endpoint << std::endl;
             return 1;
         }
         
@@ -1,10 +1,47 @@
 #include "simple_window.h"
 #include <iostream>
 #include <exception>
+#include <string>
 
-int main() {
+int main(int argc, char** argv) {
     try {
         SimpleWindow window;
+
+        std::string replayDirectory;
+        double replaySpeed = 1.0;
+        bool replayLoop = false;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--record" && i + 1 < argc) {
+                window.setRecordingDirectory(argv[++i]);
+            } else if (arg == "--replay" && i + 1 < argc) {
+                replayDirectory = argv[++i];
+            } else if (arg == "--speed" && i + 1 < argc) {
+                std::string value = argv[++i];
+                replaySpeed = value == "max" ? 0.0 : std::stod(value);
+            } else if (arg == "--loop") {
+                replayLoop = true;
+            } else if (arg == "--endpoint" && i + 1 < argc) {
+                window.setEndpoint(argv[++i]);
+            } else if (arg == "--pipeline" && i + 1 < argc) {
+                window.setPipelineDepth(std::stoul(argv[++i]));
+            } else if (arg == "--pool" && i + 1 < argc) {
+                window.setPoolSize(std::stoul(argv[++i]));
+            } else if (arg == "--discover") {
+                window.setAutoDiscover(true);
+            } else if (arg == "--devices" && i + 1 < argc) {
+                DeviceSchema schema;
+                if (!schema.load(argv[++i])) {
+                    return 1;
+                }
+                window.setDeviceSchema(schema);
+            }
+        }
+
+        if (!replayDirectory.empty()) {
+            window.setReplay(replayDirectory, replaySpeed, replayLoop);
+        }
         
         if (!window.initialize()) {
             std::cerr << "Ошибка инициализации графического интерфейса" << std::endl;
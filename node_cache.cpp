@@ -0,0 +1,118 @@
+#include "node_cache.h"
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    std::string nodeIdToString(const UA_NodeId& id) {
+        UA_String out = UA_STRING_NULL;
+        if (UA_NodeId_print(&id, &out) != UA_STATUSCODE_GOOD) return std::string();
+        std::string result((char*)out.data, out.length);
+        UA_String_clear(&out);
+        return result;
+    }
+
+    bool nodeIdFromString(const std::string& text, UA_NodeId& id) {
+        UA_String s;
+        s.length = text.size();
+        s.data = (UA_Byte*)text.data();
+        return UA_NodeId_parse(&id, s) == UA_STATUSCODE_GOOD;
+    }
+}
+
+
+
+NodeIdCache::NodeIdCache() : browseNamespace(1) {}
+
+bool NodeIdCache::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    endpoint.clear();
+    namespaceArray.clear();
+    nodes.clear();
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 2) continue;
+
+        const std::string& kind = fields[0];
+        if (kind == "endpoint") {
+            endpoint = fields[1];
+        } else if (kind == "browse-ns" || kind == "ns") {
+            // Namespace indices are UInt16 on the wire, which also bounds the
+            // namespace table a corrupt line can make us allocate.
+            const std::string& text = fields[1];
+            UA_UInt16 index = 0;
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), index);
+            if (error != std::errc() || end != text.data() + text.size()) {
+                std::cerr << "Bad line in " << path << ": " << line << std::endl;
+                continue;
+            }
+            if (kind == "browse-ns") {
+                browseNamespace = index;
+            } else if (fields.size() >= 3) {
+                if (namespaceArray.size() <= index) namespaceArray.resize(static_cast<size_t>(index) + 1);
+                namespaceArray[index] = fields[2];
+            }
+        } else if (kind == "node" && fields.size() >= 3) {
+            UA_NodeId id;
+            if (!nodeIdFromString(fields[2], id)) {
+                std::cerr << "Bad NodeId in " << path << ": " << fields[2] << std::endl;
+                continue;
+            }
+            const std::string& browsePath = fields[1];
+            std::string leaf = browsePath.substr(browsePath.rfind('/') + 1);
+            nodes[browsePath] = OPCUANode(id, leaf);
+            UA_NodeId_clear(&id);
+        }
+    }
+
+    return !endpoint.empty();
+}
+
+bool NodeIdCache::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to write NodeId cache " << path << std::endl;
+        return false;
+    }
+
+    out << "endpoint\t" << endpoint << '\n';
+    out << "browse-ns\t" << browseNamespace << '\n';
+    for (size_t i = 0; i < namespaceArray.size(); i++) {
+        out << "ns\t" << i << '\t' << namespaceArray[i] << '\n';
+    }
+    for (const auto& [browsePath, node] : nodes) {
+        out << "node\t" << browsePath << '\t' << nodeIdToString(node.getId()) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool NodeIdCache::matches(const std::string& ep, const std::vector<std::string>& namespaces) const {
+    return !namespaces.empty() && ep == endpoint && namespaces == namespaceArray;
+}
+
+void NodeIdCache::reset(const std::string& ep, const std::vector<std::string>& namespaces) {
+    endpoint = ep;
+    namespaceArray = namespaces;
+    nodes.clear();
+}
+
+void NodeIdCache::set(const std::string& browsePath, const OPCUANode& node) {
+    if (node.isValid()) {
+        nodes[browsePath] = node;
+    }
+}
+
+OPCUANode NodeIdCache::find(const std::string& browsePath) const {
+    auto it = nodes.find(browsePath);
+    return it != nodes.end() ? it->second : OPCUANode();
+}
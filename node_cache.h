@@ -0,0 +1,36 @@
+#ifndef NODE_CACHE_H
+#define NODE_CACHE_H
+
+#include "opcua_client.h"
+#include <map>
+#include <string>
+#include <vector>
+
+
+// Resolved NodeIds keyed by browse path ("Machine/FlywheelRPM"), valid only
+// for the endpoint and namespace array they were resolved against.
+class NodeIdCache {
+private:
+    std::string endpoint;
+    std::vector<std::string> namespaceArray;
+    UA_UInt16 browseNamespace;
+    std::map<std::string, OPCUANode> nodes;
+
+public:
+    NodeIdCache();
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    bool matches(const std::string& endpoint, const std::vector<std::string>& namespaceArray) const;
+    void reset(const std::string& endpoint, const std::vector<std::string>& namespaceArray);
+
+    void set(const std::string& browsePath, const OPCUANode& node);
+    OPCUANode find(const std::string& browsePath) const;
+    size_t size() const { return nodes.size(); }
+
+    UA_UInt16 getBrowseNamespace() const { return browseNamespace; }
+    void setBrowseNamespace(UA_UInt16 ns) { browseNamespace = ns; }
+};
+
+#endif
@@ -1,10 +1,35 @@
 #include "opcua_client.h"
 #include <iostream>
-#include <cstring>
+#include <cmath>
 #include <type_traits>
+#include <algorithm>
 
 
 
+namespace {
+    int64_t toUnixMicros(UA_DateTime t) {
+        return (t - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC;
+    }
+}
+
+bool decodeSample(const UA_DataValue& dv, CachedDecoder<double>& decoder, TagSample& out) {
+    out.status = dv.hasStatus ? dv.status : UA_STATUSCODE_GOOD;
+    out.sourceTs = dv.hasSourceTimestamp ? toUnixMicros(dv.sourceTimestamp) : 0;
+    out.serverTs = dv.hasServerTimestamp ? toUnixMicros(dv.serverTimestamp) : 0;
+    if (UA_StatusCode_isBad(out.status)) return false;
+
+    if (!dv.hasValue) {
+        out.status = UA_STATUSCODE_BADNODATA;
+        return false;
+    }
+    if (!decoder.decodeScalar(dv.value, out.value)) {
+        out.status = UA_STATUSCODE_BADTYPEMISMATCH;
+        return false;
+    }
+    return true;
+}
+
+
 OPCUANode::OPCUANode() : nodeId(UA_NODEID_NULL) {}
 
 OPCUANode::OPCUANode(const UA_NodeId& id, const std::string& bName, const std::string& dName) 
@@ -64,24 +89,37 @@ void OPCUANode::printInfo() const {
 
 
 
-OPCUAClient::OPCUAClient(const std::string& endpoint) 
-    : client(nullptr), endpoint(endpoint) {}
+PreparedRead::PreparedRead() {
+    UA_ReadRequest_init(&request);
+}
 
-OPCUAClient::OPCUAClient(OPCUAClient&& other) noexcept 
-    : client(other.client), endpoint(std::move(other.endpoint)) {
-    other.client = nullptr;
+PreparedRead::~PreparedRead() {
+    UA_ReadRequest_clear(&request);
 }
 
-OPCUAClient& OPCUAClient::operator=(OPCUAClient&& other) noexcept {
+PreparedRead::PreparedRead(PreparedRead&& other) noexcept
+    : request(other.request), encodedSize(other.encodedSize), scalarCount(other.scalarCount),
+      decoders(std::move(other.decoders)) {
+    UA_ReadRequest_init(&other.request);
+}
+
+PreparedRead& PreparedRead::operator=(PreparedRead&& other) noexcept {
     if (this != &other) {
-        cleanup();
-        client = other.client;
-        endpoint = std::move(other.endpoint);
-        other.client = nullptr;
+        UA_ReadRequest_clear(&request);
+        request = other.request;
+        encodedSize = other.encodedSize;
+        scalarCount = other.scalarCount;
+        decoders = std::move(other.decoders);
+        UA_ReadRequest_init(&other.request);
     }
     return *this;
 }
 
+
+
+OPCUAClient::OPCUAClient(const std::string& endpoint) 
+    : client(nullptr), endpoint(endpoint) {}
+
 OPCUAClient::~OPCUAClient() {
     disconnect();
     cleanup();
@@ -95,14 +133,17 @@ void OPCUAClient::cleanup() {
 }
 
 bool OPCUAClient::connect() {
-    if (client) return false;
+    if (client && isConnected()) return true;
 
-    client = UA_Client_new();
-    if (!client) return false;
+    if (!client) {
+        client = UA_Client_new();
+        if (!client) return false;
 
-    UA_ClientConfig* config = UA_Client_getConfig(client);
-    UA_ClientConfig_setDefault(config);
-    config->timeout = 5000;
+        UA_ClientConfig* config = UA_Client_getConfig(client);
+        UA_ClientConfig_setDefault(config);
+        config->timeout = 5000;
+        installHooks();
+    }
 
     UA_StatusCode status = UA_Client_connect(client, endpoint.c_str());
     if (status != UA_STATUSCODE_GOOD) {
@@ -111,10 +152,165 @@ bool OPCUAClient::connect() {
         return false;
     }
 
+    refreshNamespaceArray();
+    reconnecting = false;
+    reconnectPending = false;
+    reconnectBackoff.reset();
+    sessionUp = true;
+    sessionGeneration++;
     return true;
 }
 
+void OPCUAClient::enableAutoReconnect(const BackoffPolicy& policy) {
+    reconnectBackoff = ExponentialBackoff(policy);
+    autoReconnect = true;
+}
+
+bool OPCUAClient::superviseConnection() {
+    UA_SecureChannelState channelState;
+    UA_SessionState sessionState;
+    UA_StatusCode connectStatus;
+    UA_Client_getState(client, &channelState, &sessionState, &connectStatus);
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (channelState == UA_SECURECHANNELSTATE_OPEN && sessionState == UA_SESSIONSTATE_ACTIVATED) {
+        if (!sessionUp) {
+            sessionUp = true;
+            reconnectPending = false;
+            reconnectBackoff.reset();
+            if (reconnecting) {
+                reconnecting = false;
+                reconnects.fetch_add(1, std::memory_order_relaxed);
+                lastRecoveryMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - outageStart).count();
+                sessionGeneration++;
+                refreshNamespaceArray();
+                std::cerr << "Reconnected to " << endpoint << " after " << lastRecoveryMs << " ms" << std::endl;
+            }
+        }
+        return true;
+    }
+
+    if (sessionUp) {
+        sessionUp = false;
+        reconnecting = true;
+        outageStart = now;
+        nextReconnectAt = now;
+        std::cerr << "Connection to " << endpoint << " lost: " << UA_StatusCode_name(connectStatus) << std::endl;
+    }
+    if (!reconnecting) return true;
+
+    if (reconnectPending) {
+        if (connectStatus == UA_STATUSCODE_GOOD) return true;
+        reconnectPending = false;
+        nextReconnectAt = now + reconnectBackoff.next();
+    }
+    if (now < nextReconnectAt) return false;
+
+    reconnectPending = UA_Client_connectAsync(client, endpoint.c_str()) == UA_STATUSCODE_GOOD;
+    if (!reconnectPending) {
+        nextReconnectAt = now + reconnectBackoff.next();
+    }
+    return reconnectPending;
+}
+
+void OPCUAClient::installHooks() {
+    UA_ClientConfig* config = UA_Client_getConfig(client);
+    config->clientContext = this;
+    config->stateCallback = stateCallback;
+}
+
+void OPCUAClient::stateCallback(UA_Client* client, UA_SecureChannelState channelState,
+                                UA_SessionState sessionState, UA_StatusCode connectStatus) {
+    auto* self = static_cast<OPCUAClient*>(UA_Client_getContext(client));
+    if (!self) return;
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(self->healthMutex);
+    bool wasOpen = self->lastChannelState == UA_SECURECHANNELSTATE_OPEN;
+    bool isOpen = channelState == UA_SECURECHANNELSTATE_OPEN;
+    if (isOpen && !wasOpen) {
+        self->health.channelOpens++;
+        self->channelOpenedAt = now;
+        self->channelLifetime = std::chrono::milliseconds(UA_Client_getConfig(client)->secureChannelLifeTime);
+    } else if (wasOpen && !isOpen) {
+        self->health.expectedChannelRenewals += self->expectedRenewalsSinceOpen(now);
+    }
+    self->lastChannelState = channelState;
+}
+
+// The stack keeps the token renewal to itself (no callback, no public
+// counter), so this only estimates it from the fixed renewal schedule.
+uint64_t OPCUAClient::expectedRenewalsSinceOpen(std::chrono::steady_clock::time_point now) const {
+    auto period = channelLifetime * 3 / 4;
+    if (period.count() <= 0 || now < channelOpenedAt) return 0;
+    return static_cast<uint64_t>((now - channelOpenedAt) / period);
+}
+
+void OPCUAClient::recordService(std::chrono::steady_clock::time_point sent, UA_StatusCode status,
+                                size_t sentBytes, size_t receivedBytes) const {
+    auto now = std::chrono::steady_clock::now();
+
+    bool notSent = status == UA_STATUSCODE_BADNOTCONNECTED || status == UA_STATUSCODE_BADSERVERNOTCONNECTED ||
+                   status == UA_STATUSCODE_BADSHUTDOWN;
+    bool timedOut = status == UA_STATUSCODE_BADTIMEOUT || status == UA_STATUSCODE_BADREQUESTTIMEOUT;
+    bool lost = timedOut || status == UA_STATUSCODE_BADCONNECTIONCLOSED ||
+                status == UA_STATUSCODE_BADSECURECHANNELCLOSED;
+    bool sessionGone = status == UA_STATUSCODE_BADSESSIONIDINVALID || status == UA_STATUSCODE_BADSESSIONCLOSED ||
+                       status == UA_STATUSCODE_BADSESSIONNOTACTIVATED;
+
+    std::lock_guard<std::mutex> lock(healthMutex);
+    health.requests++;
+    if (status != UA_STATUSCODE_GOOD) health.serviceFaults++;
+    if (timedOut) health.requestTimeouts++;
+    if (sessionGone) health.sessionTimeouts++;
+    if (notSent) return;
+
+    bool counting = trafficStats.load(std::memory_order_relaxed);
+    if (counting) health.bytesSent += sentBytes;
+    if (lost) return;
+
+    if (counting) health.bytesReceived += receivedBytes;
+    double rtt = std::chrono::duration<double, std::milli>(now - sent).count();
+    if (lastResponseAt == std::chrono::steady_clock::time_point()) {
+        health.rttMs = rtt;
+        health.rttVarMs = rtt / 2.0;
+    } else {
+        health.rttVarMs += (std::abs(health.rttMs - rtt) - health.rttVarMs) / 4.0;
+        health.rttMs += (rtt - health.rttMs) / 8.0;
+    }
+    health.lastRttMs = rtt;
+    health.rttMaxMs = std::max(health.rttMaxMs, rtt);
+    lastResponseAt = now;
+}
+
+ConnectionHealth OPCUAClient::getHealth() const {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(healthMutex);
+    ConnectionHealth snapshot = health;
+    if (lastChannelState == UA_SECURECHANNELSTATE_OPEN) {
+        snapshot.expectedChannelRenewals += expectedRenewalsSinceOpen(now);
+    }
+    if (lastResponseAt != std::chrono::steady_clock::time_point()) {
+        snapshot.msSinceLastResponse = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - lastResponseAt).count();
+    }
+    return snapshot;
+}
+
+void OPCUAClient::resetHealth() {
+    std::lock_guard<std::mutex> lock(healthMutex);
+    health = ConnectionHealth();
+    lastResponseAt = std::chrono::steady_clock::time_point();
+    channelOpenedAt = std::chrono::steady_clock::now();
+}
+
 void OPCUAClient::disconnect() {
+    failPendingWrites(UA_STATUSCODE_BADCONNECTIONCLOSED);
+    failQueuedAsync(UA_STATUSCODE_BADCONNECTIONCLOSED);
+    sessionUp = false;
+    reconnecting = false;
+    reconnectPending = false;
     if (client) {
         UA_Client_disconnect(client);
     }
@@ -136,100 +332,592 @@ bool OPCUAClient::isConnected() const {
 OPCUANode OPCUAClient::findNodeByBrowseName(const OPCUANode& parentNode, const std::string& browseName) const {
     if (!client || !parentNode.isValid()) return OPCUANode();
 
-    UA_BrowseRequest bReq;
-    UA_BrowseRequest_init(&bReq);
-    
-    bReq.requestedMaxReferencesPerNode = 0;
-    bReq.nodesToBrowseSize = 1;
-    bReq.nodesToBrowse = (UA_BrowseDescription*)UA_Array_new(1, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
-    
-    bReq.nodesToBrowse[0].nodeId = parentNode.getId();
-    bReq.nodesToBrowse[0].resultMask = UA_BROWSERESULTMASK_ALL;
-    bReq.nodesToBrowse[0].browseDirection = UA_BROWSEDIRECTION_FORWARD;
-    bReq.nodesToBrowse[0].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
-    bReq.nodesToBrowse[0].includeSubtypes = true;
-    bReq.nodesToBrowse[0].nodeClassMask = UA_NODECLASS_VARIABLE | UA_NODECLASS_OBJECT;
-    
-    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
-    
-    OPCUANode result;
-    
-    if (bResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
-        for (size_t i = 0; i < bResp.resultsSize; i++) {
-            UA_BrowseResult* res = &bResp.results[i];
-            if (res->statusCode == UA_STATUSCODE_GOOD) {
-                for (size_t j = 0; j < res->referencesSize; j++) {
-                    UA_ReferenceDescription* ref = &res->references[j];
-                    
-                    if (ref->browseName.name.length > 0) {
-                        std::string name((char*)ref->browseName.name.data, ref->browseName.name.length);
-                        if (name == browseName) {
-                            std::string displayName = "";
-                            if (ref->displayName.text.length > 0) {
-                                displayName = std::string((char*)ref->displayName.text.data, 
-                                                         ref->displayName.text.length);
-                            }
-                            result = OPCUANode(ref->nodeId.nodeId, browseName, displayName);
-                            break;
-                        }
-                    }
-                }
-            }
-            if (result.isValid()) break;
+    for (const auto& ref : getReferences(parentNode)) {
+        if (ref.node.getBrowseName() == browseName) {
+            return ref.node;
         }
     }
-    
-    UA_BrowseRequest_clear(&bReq);
-    UA_BrowseResponse_clear(&bResp);
-    
-    return result;
+
+    return OPCUANode();
 }
 
 std::vector<OPCUANode> OPCUAClient::findDeviceComponents(const OPCUANode& deviceNode) const {
     std::vector<OPCUANode> components;
     if (!client || !deviceNode.isValid()) return components;
 
+    for (const auto& ref : getReferences(deviceNode)) {
+        if (ref.nodeClass == UA_NODECLASS_VARIABLE) {
+            components.push_back(ref.node);
+        }
+    }
+
+    return components;
+}
+
+std::vector<BrowseReference> OPCUAClient::getReferences(const OPCUANode& node) const {
+    {
+        std::lock_guard<std::mutex> lock(browseCacheMutex);
+        auto it = browseCache.find(node);
+        if (it != browseCache.end()) return it->second;
+    }
+
+    browseNodes({node});
+
+    std::lock_guard<std::mutex> lock(browseCacheMutex);
+    auto it = browseCache.find(node);
+    return it != browseCache.end() ? it->second : std::vector<BrowseReference>();
+}
+
+namespace {
+    void appendReferences(const UA_BrowseResult& result, std::vector<BrowseReference>& out) {
+        for (size_t j = 0; j < result.referencesSize; j++) {
+            const UA_ReferenceDescription& ref = result.references[j];
+            if (ref.browseName.name.length == 0) continue;
+
+            std::string browseName((char*)ref.browseName.name.data, ref.browseName.name.length);
+            std::string displayName((char*)ref.displayName.text.data, ref.displayName.text.length);
+
+            UA_UInt32 referenceType = 0;
+            if (ref.referenceTypeId.namespaceIndex == 0 &&
+                ref.referenceTypeId.identifierType == UA_NODEIDTYPE_NUMERIC) {
+                referenceType = ref.referenceTypeId.identifier.numeric;
+            }
+
+            out.push_back({OPCUANode(ref.nodeId.nodeId, browseName, displayName), ref.nodeClass, referenceType,
+                           ref.browseName.namespaceIndex});
+        }
+    }
+
+    void initBrowseDescription(UA_BrowseDescription& desc, const UA_NodeId& nodeId) {
+        UA_NodeId_copy(&nodeId, &desc.nodeId);
+        desc.resultMask = UA_BROWSERESULTMASK_ALL;
+        desc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        desc.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+        desc.includeSubtypes = true;
+        desc.nodeClassMask = UA_NODECLASS_VARIABLE | UA_NODECLASS_OBJECT;
+    }
+}
+
+bool OPCUAClient::browseNodes(const std::vector<OPCUANode>& nodes) const {
+    if (!client) return false;
+
+    std::vector<OPCUANode> pending;
+    {
+        std::lock_guard<std::mutex> lock(browseCacheMutex);
+        for (const auto& node : nodes) {
+            if (!node.isValid() || browseCache.count(node)) continue;
+            bool queued = std::any_of(pending.begin(), pending.end(), [&](const OPCUANode& p) {
+                return UA_NodeId_equal(&p.getId(), &node.getId());
+            });
+            if (!queued) pending.push_back(node);
+        }
+    }
+    if (pending.empty()) return true;
+
     UA_BrowseRequest bReq;
     UA_BrowseRequest_init(&bReq);
-    
+
     bReq.requestedMaxReferencesPerNode = 0;
-    bReq.nodesToBrowseSize = 1;
-    bReq.nodesToBrowse = (UA_BrowseDescription*)UA_Array_new(1, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
-    
-    bReq.nodesToBrowse[0].nodeId = deviceNode.getId();
-    bReq.nodesToBrowse[0].resultMask = UA_BROWSERESULTMASK_ALL;
-    bReq.nodesToBrowse[0].browseDirection = UA_BROWSEDIRECTION_FORWARD;
-    bReq.nodesToBrowse[0].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
-    bReq.nodesToBrowse[0].includeSubtypes = true;
-    bReq.nodesToBrowse[0].nodeClassMask = UA_NODECLASS_VARIABLE;
-    
+    bReq.nodesToBrowseSize = pending.size();
+    bReq.nodesToBrowse = (UA_BrowseDescription*)UA_Array_new(pending.size(), &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        initBrowseDescription(bReq.nodesToBrowse[i], pending[i].getId());
+    }
+
+    auto sent = std::chrono::steady_clock::now();
     UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
-    
-    if (bResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
-        for (size_t i = 0; i < bResp.resultsSize; i++) {
-            UA_BrowseResult* res = &bResp.results[i];
-            if (res->statusCode == UA_STATUSCODE_GOOD) {
-                for (size_t j = 0; j < res->referencesSize; j++) {
-                    UA_ReferenceDescription* ref = &res->references[j];
-                    
-                    if (ref->browseName.name.length > 0) {
-                        std::string browseName((char*)ref->browseName.name.data, ref->browseName.name.length);
-                        std::string displayName = "";
-                        if (ref->displayName.text.length > 0) {
-                            displayName = std::string((char*)ref->displayName.text.data, 
-                                                     ref->displayName.text.length);
-                        }
-                        components.push_back(OPCUANode(ref->nodeId.nodeId, browseName, displayName));
+    browseRequests.fetch_add(1, std::memory_order_relaxed);
+    recordService(sent, bResp.responseHeader.serviceResult,
+                  encodedSize(&bReq, &UA_TYPES[UA_TYPES_BROWSEREQUEST]),
+                  encodedSize(&bResp, &UA_TYPES[UA_TYPES_BROWSERESPONSE]));
+    UA_BrowseRequest_clear(&bReq);
+
+    if (bResp.responseHeader.serviceResult != UA_STATUSCODE_GOOD || bResp.resultsSize != pending.size()) {
+        std::cerr << "Browse failed: " << UA_StatusCode_name(bResp.responseHeader.serviceResult) << std::endl;
+        UA_BrowseResponse_clear(&bResp);
+        return false;
+    }
+
+    std::vector<std::vector<BrowseReference>> references(pending.size());
+    std::vector<bool> good(pending.size(), false);
+    std::vector<size_t> continuing;
+
+    UA_BrowseNextRequest nextReq;
+    UA_BrowseNextRequest_init(&nextReq);
+    nextReq.continuationPoints = (UA_ByteString*)UA_Array_new(pending.size(), &UA_TYPES[UA_TYPES_BYTESTRING]);
+
+    for (size_t i = 0; i < bResp.resultsSize; i++) {
+        const UA_BrowseResult& res = bResp.results[i];
+        if (res.statusCode != UA_STATUSCODE_GOOD) continue;
+        good[i] = true;
+        appendReferences(res, references[i]);
+        if (res.continuationPoint.length > 0) {
+            UA_ByteString_copy(&res.continuationPoint, &nextReq.continuationPoints[continuing.size()]);
+            continuing.push_back(i);
+        }
+    }
+    UA_BrowseResponse_clear(&bResp);
+
+    while (!continuing.empty()) {
+        nextReq.continuationPointsSize = continuing.size();
+        sent = std::chrono::steady_clock::now();
+        UA_BrowseNextResponse nextResp = UA_Client_Service_browseNext(client, nextReq);
+        browseRequests.fetch_add(1, std::memory_order_relaxed);
+        recordService(sent, nextResp.responseHeader.serviceResult,
+                      encodedSize(&nextReq, &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST]),
+                      encodedSize(&nextResp, &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE]));
+
+        if (nextResp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+            nextResp.resultsSize != continuing.size()) {
+            std::cerr << "BrowseNext failed: " << UA_StatusCode_name(nextResp.responseHeader.serviceResult) << std::endl;
+            for (size_t index : continuing) good[index] = false;
+            UA_BrowseNextResponse_clear(&nextResp);
+
+            nextReq.releaseContinuationPoints = true;
+            UA_BrowseNextResponse releaseResp = UA_Client_Service_browseNext(client, nextReq);
+            UA_BrowseNextResponse_clear(&releaseResp);
+            break;
+        }
+
+        for (size_t k = 0; k < continuing.size(); k++) {
+            UA_ByteString_clear(&nextReq.continuationPoints[k]);
+        }
+
+        std::vector<size_t> stillContinuing;
+        for (size_t k = 0; k < nextResp.resultsSize; k++) {
+            const UA_BrowseResult& res = nextResp.results[k];
+            size_t index = continuing[k];
+            if (res.statusCode != UA_STATUSCODE_GOOD) {
+                good[index] = false;
+                continue;
+            }
+            appendReferences(res, references[index]);
+            if (res.continuationPoint.length > 0) {
+                UA_ByteString_copy(&res.continuationPoint, &nextReq.continuationPoints[stillContinuing.size()]);
+                stillContinuing.push_back(index);
+            }
+        }
+
+        UA_BrowseNextResponse_clear(&nextResp);
+        continuing.swap(stillContinuing);
+    }
+
+    nextReq.continuationPointsSize = pending.size();
+    UA_BrowseNextRequest_clear(&nextReq);
+
+    std::lock_guard<std::mutex> lock(browseCacheMutex);
+    bool allGood = true;
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (good[i]) {
+            browseCache[pending[i]] = std::move(references[i]);
+        } else {
+            allGood = false;
+        }
+    }
+    return allGood;
+}
+
+struct OPCUAClient::DiscoveryState {
+    OPCUANode root;
+    DiscoveryOptions options;
+    std::vector<DiscoveredNode>* out{nullptr};
+    std::unordered_set<OPCUANode, NodeIdHash, NodeIdEqual> visited;
+    std::deque<uint32_t> frontier;
+    std::deque<std::pair<uint32_t, UA_ByteString>> continuations;
+    std::unordered_map<uint32_t, std::vector<BrowseReference>> partial;
+    size_t batch{1};
+    size_t inFlight{0};
+    bool complete{true};
+    bool truncated{false};
+    bool abandoned{false};
+
+    const OPCUANode& nodeOf(uint32_t owner) const { return owner == DiscoveredNode::ROOT ? root : (*out)[owner].node; }
+
+    ~DiscoveryState() {
+        for (auto& entry : continuations) UA_ByteString_clear(&entry.second);
+    }
+};
+
+struct OPCUAClient::DiscoveryCall {
+    const OPCUAClient* client{nullptr};
+    std::shared_ptr<DiscoveryState> state;
+    std::vector<uint32_t> owners;
+    bool next{false};
+    size_t sentBytes{0};
+    std::chrono::steady_clock::time_point sent;
+};
+
+// Breadth-first walk of the hierarchy below root. Up to maxInFlight
+// Browse/BrowseNext requests are kept outstanding, each carrying up to
+// nodesPerRequest nodes, and continuation points are drained before new nodes
+// are browsed so the server's per-session limit is not exhausted. Every
+// completed node lands in the browse cache, and nodes already cached cost no
+// request. Returns false if anything was left unbrowsed; nodes holds whatever
+// was reached either way.
+bool OPCUAClient::discover(const OPCUANode& root, std::vector<DiscoveredNode>& nodes,
+                           const DiscoveryOptions& options) const {
+    nodes.clear();
+    if (!client || !root.isValid()) return false;
+
+    auto state = std::make_shared<DiscoveryState>();
+    state->root = root;
+    state->options = options;
+    state->options.maxInFlight = std::max<size_t>(options.maxInFlight, 1);
+    state->batch = std::max<size_t>(options.nodesPerRequest, 1);
+    state->out = &nodes;
+    state->visited.insert(root);
+    state->frontier.push_back(DiscoveredNode::ROOT);
+
+    while (issueDiscovery(state) && state->inFlight > 0) {
+        UA_StatusCode status = UA_Client_run_iterate(client, 100);
+        if (status != UA_STATUSCODE_GOOD) {
+            std::cerr << "Discovery aborted: " << UA_StatusCode_name(status) << std::endl;
+            state->complete = false;
+            break;
+        }
+    }
+
+    // Responses still outstanding after an abort only release their call.
+    state->abandoned = true;
+    releaseContinuationPoints(*state);
+
+    return state->complete && !state->truncated;
+}
+
+bool OPCUAClient::issueDiscovery(const std::shared_ptr<DiscoveryState>& state) const {
+    DiscoveryState& s = *state;
+
+    while (!s.truncated && s.inFlight < s.options.maxInFlight) {
+        auto call = std::make_unique<DiscoveryCall>();
+        call->client = this;
+        call->state = state;
+
+        UA_StatusCode status;
+        if (!s.continuations.empty()) {
+            size_t count = std::min(s.continuations.size(), s.batch);
+
+            UA_BrowseNextRequest nextReq;
+            UA_BrowseNextRequest_init(&nextReq);
+            nextReq.continuationPoints = (UA_ByteString*)UA_Array_new(count, &UA_TYPES[UA_TYPES_BYTESTRING]);
+            nextReq.continuationPointsSize = count;
+            for (size_t i = 0; i < count; i++) {
+                call->owners.push_back(s.continuations.front().first);
+                nextReq.continuationPoints[i] = s.continuations.front().second;
+                s.continuations.pop_front();
+            }
+
+            call->next = true;
+            call->sentBytes = encodedSize(&nextReq, &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST]);
+            call->sent = std::chrono::steady_clock::now();
+            status = UA_Client_sendAsyncRequest(client, &nextReq, &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST],
+                                                discoveryCallback, &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE],
+                                                call.get(), nullptr);
+            UA_BrowseNextRequest_clear(&nextReq);
+        } else {
+            while (!s.frontier.empty() && call->owners.size() < s.batch) {
+                uint32_t owner = s.frontier.front();
+                s.frontier.pop_front();
+
+                std::vector<BrowseReference> cached;
+                bool hit = false;
+                {
+                    std::lock_guard<std::mutex> lock(browseCacheMutex);
+                    auto it = browseCache.find(s.nodeOf(owner));
+                    if (it != browseCache.end()) {
+                        cached = it->second;
+                        hit = true;
                     }
                 }
+
+                if (hit) {
+                    expandDiscovered(s, owner, cached);
+                } else {
+                    call->owners.push_back(owner);
+                }
+            }
+            if (call->owners.empty()) {
+                if (s.frontier.empty()) break;
+                continue;
+            }
+
+            UA_BrowseRequest bReq;
+            UA_BrowseRequest_init(&bReq);
+            bReq.requestedMaxReferencesPerNode = 0;
+            bReq.nodesToBrowseSize = call->owners.size();
+            bReq.nodesToBrowse = (UA_BrowseDescription*)UA_Array_new(call->owners.size(),
+                                                                     &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+            for (size_t i = 0; i < call->owners.size(); i++) {
+                initBrowseDescription(bReq.nodesToBrowse[i], s.nodeOf(call->owners[i]).getId());
             }
+
+            call->sentBytes = encodedSize(&bReq, &UA_TYPES[UA_TYPES_BROWSEREQUEST]);
+            call->sent = std::chrono::steady_clock::now();
+            status = UA_Client_sendAsyncRequest(client, &bReq, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                                                discoveryCallback, &UA_TYPES[UA_TYPES_BROWSERESPONSE],
+                                                call.get(), nullptr);
+            UA_BrowseRequest_clear(&bReq);
+        }
+
+        browseRequests.fetch_add(1, std::memory_order_relaxed);
+        if (status != UA_STATUSCODE_GOOD) {
+            std::cerr << "Discovery browse failed: " << UA_StatusCode_name(status) << std::endl;
+            s.complete = false;
+            return false;
         }
+
+        call.release();
+        s.inFlight++;
     }
-    
-    UA_BrowseRequest_clear(&bReq);
-    UA_BrowseResponse_clear(&bResp);
-    
-    return components;
+
+    return true;
+}
+
+void OPCUAClient::discoveryCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, void* response) {
+    std::unique_ptr<DiscoveryCall> call(static_cast<DiscoveryCall*>(userdata));
+    DiscoveryState& s = *call->state;
+    s.inFlight--;
+    if (s.abandoned) return;
+
+    const UA_ResponseHeader* header;
+    const UA_BrowseResult* results;
+    size_t resultsSize;
+    size_t receivedBytes;
+    if (call->next) {
+        const auto* nextResp = static_cast<const UA_BrowseNextResponse*>(response);
+        header = &nextResp->responseHeader;
+        results = nextResp->results;
+        resultsSize = nextResp->resultsSize;
+        receivedBytes = call->client->encodedSize(nextResp, &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE]);
+    } else {
+        const auto* bResp = static_cast<const UA_BrowseResponse*>(response);
+        header = &bResp->responseHeader;
+        results = bResp->results;
+        resultsSize = bResp->resultsSize;
+        receivedBytes = call->client->encodedSize(bResp, &UA_TYPES[UA_TYPES_BROWSERESPONSE]);
+    }
+    call->client->recordService(call->sent, header->serviceResult, call->sentBytes, receivedBytes);
+
+    // A server with a lower operation limit than nodesPerRequest rejects the
+    // whole request; retry those nodes in smaller batches.
+    if (!call->next && header->serviceResult == UA_STATUSCODE_BADTOOMANYOPERATIONS && call->owners.size() > 1) {
+        s.batch = std::max<size_t>(call->owners.size() / 2, 1);
+        s.frontier.insert(s.frontier.begin(), call->owners.begin(), call->owners.end());
+        return;
+    }
+
+    if (header->serviceResult != UA_STATUSCODE_GOOD || resultsSize != call->owners.size()) {
+        std::cerr << "Discovery browse failed: " << UA_StatusCode_name(header->serviceResult) << std::endl;
+        s.complete = false;
+        for (uint32_t owner : call->owners) s.partial.erase(owner);
+        return;
+    }
+
+    for (size_t i = 0; i < resultsSize; i++) {
+        const UA_BrowseResult& res = results[i];
+        uint32_t owner = call->owners[i];
+
+        // Our own continuation points are using up the server's allowance;
+        // browse the node again once some of them have been drained.
+        bool retry = res.statusCode == UA_STATUSCODE_BADNOCONTINUATIONPOINTS &&
+                     (!s.continuations.empty() || s.inFlight > 0);
+        if (!call->next && retry) {
+            s.frontier.push_back(owner);
+            continue;
+        }
+        if (res.statusCode != UA_STATUSCODE_GOOD) {
+            s.complete = false;
+            s.partial.erase(owner);
+            continue;
+        }
+
+        std::vector<BrowseReference>& references = s.partial[owner];
+        appendReferences(res, references);
+
+        if (res.continuationPoint.length > 0) {
+            UA_ByteString continuationPoint;
+            UA_ByteString_copy(&res.continuationPoint, &continuationPoint);
+            s.continuations.emplace_back(owner, continuationPoint);
+            continue;
+        }
+
+        std::vector<BrowseReference> done = std::move(references);
+        s.partial.erase(owner);
+        {
+            std::lock_guard<std::mutex> lock(call->client->browseCacheMutex);
+            call->client->browseCache[s.nodeOf(owner)] = done;
+        }
+        call->client->expandDiscovered(s, owner, done);
+    }
+}
+
+void OPCUAClient::expandDiscovered(DiscoveryState& state, uint32_t owner,
+                                   const std::vector<BrowseReference>& references) const {
+    if (state.truncated) return;
+
+    std::vector<DiscoveredNode>& out = *state.out;
+    uint32_t depth = owner == DiscoveredNode::ROOT ? 0 : out[owner].depth + 1;
+
+    for (const auto& ref : references) {
+        if (!state.options.includeNamespaceZero && ref.node.getId().namespaceIndex == 0) continue;
+        if (!state.visited.insert(ref.node).second) continue;
+
+        if (out.size() >= state.options.maxNodes) {
+            std::cerr << "Discovery stopped at " << state.options.maxNodes << " nodes" << std::endl;
+            state.truncated = true;
+            state.frontier.clear();
+            return;
+        }
+
+        std::string path = owner == DiscoveredNode::ROOT
+            ? ref.node.getBrowseName()
+            : out[owner].path + "/" + ref.node.getBrowseName();
+
+        uint32_t index = static_cast<uint32_t>(out.size());
+        out.push_back({ref.node, ref.nodeClass, owner, depth, std::move(path)});
+
+        if (ref.nodeClass == UA_NODECLASS_OBJECT && depth + 1 < state.options.maxDepth) {
+            state.frontier.push_back(index);
+        }
+    }
+}
+
+void OPCUAClient::releaseContinuationPoints(DiscoveryState& state) const {
+    if (state.continuations.empty() || !client) return;
+
+    UA_BrowseNextRequest nextReq;
+    UA_BrowseNextRequest_init(&nextReq);
+    nextReq.releaseContinuationPoints = true;
+    nextReq.continuationPoints = (UA_ByteString*)UA_Array_new(state.continuations.size(), &UA_TYPES[UA_TYPES_BYTESTRING]);
+    nextReq.continuationPointsSize = state.continuations.size();
+    for (size_t i = 0; i < nextReq.continuationPointsSize; i++) {
+        nextReq.continuationPoints[i] = state.continuations[i].second;
+    }
+    state.continuations.clear();
+
+    UA_BrowseNextResponse nextResp = UA_Client_Service_browseNext(client, nextReq);
+    browseRequests.fetch_add(1, std::memory_order_relaxed);
+    UA_BrowseNextRequest_clear(&nextReq);
+    UA_BrowseNextResponse_clear(&nextResp);
+}
+
+void OPCUAClient::clearBrowseCache() {
+    std::lock_guard<std::mutex> lock(browseCacheMutex);
+    browseCache.clear();
+}
+
+size_t OPCUAClient::browseCacheSize() const {
+    std::lock_guard<std::mutex> lock(browseCacheMutex);
+    return browseCache.size();
+}
+
+std::vector<OPCUANode> OPCUAClient::translateBrowsePaths(const OPCUANode& startNode,
+                                                      const std::vector<std::string>& paths,
+                                                      UA_UInt16 namespaceIndex) const {
+    std::vector<OPCUANode> resolved(paths.size());
+    if (!client || !startNode.isValid() || paths.empty()) return resolved;
+
+    UA_TranslateBrowsePathsToNodeIdsRequest tReq;
+    UA_TranslateBrowsePathsToNodeIdsRequest_init(&tReq);
+    tReq.browsePathsSize = paths.size();
+    tReq.browsePaths = (UA_BrowsePath*)UA_Array_new(paths.size(), &UA_TYPES[UA_TYPES_BROWSEPATH]);
+
+    std::vector<std::string> leafNames(paths.size());
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::vector<std::string> elements;
+        size_t begin = 0;
+        while (begin <= paths[i].size()) {
+            size_t slash = paths[i].find('/', begin);
+            if (slash == std::string::npos) slash = paths[i].size();
+            if (slash > begin) elements.push_back(paths[i].substr(begin, slash - begin));
+            begin = slash + 1;
+        }
+        if (!elements.empty()) leafNames[i] = elements.back();
+
+        UA_BrowsePath& path = tReq.browsePaths[i];
+        UA_NodeId_copy(&startNode.getId(), &path.startingNode);
+        path.relativePath.elementsSize = elements.size();
+        path.relativePath.elements = (UA_RelativePathElement*)UA_Array_new(
+            elements.size(), &UA_TYPES[UA_TYPES_RELATIVEPATHELEMENT]);
+
+        for (size_t e = 0; e < elements.size(); e++) {
+            UA_RelativePathElement& element = path.relativePath.elements[e];
+            element.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+            element.isInverse = false;
+            element.includeSubtypes = true;
+            element.targetName = UA_QUALIFIEDNAME_ALLOC(namespaceIndex, elements[e].c_str());
+        }
+    }
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_TranslateBrowsePathsToNodeIdsResponse tResp = UA_Client_Service_translateBrowsePathsToNodeIds(client, tReq);
+    translateRequests.fetch_add(1, std::memory_order_relaxed);
+    recordService(sent, tResp.responseHeader.serviceResult,
+                  encodedSize(&tReq, &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST]),
+                  encodedSize(&tResp, &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSRESPONSE]));
+
+    if (tResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD && tResp.resultsSize == paths.size()) {
+        for (size_t i = 0; i < tResp.resultsSize; i++) {
+            const UA_BrowsePathResult& result = tResp.results[i];
+            if (result.statusCode == UA_STATUSCODE_GOOD && result.targetsSize > 0) {
+                resolved[i] = OPCUANode(result.targets[0].targetId.nodeId, leafNames[i]);
+            }
+        }
+    } else {
+        std::cerr << "TranslateBrowsePathsToNodeIds failed: "
+                  << UA_StatusCode_name(tResp.responseHeader.serviceResult) << std::endl;
+    }
+
+    UA_TranslateBrowsePathsToNodeIdsRequest_clear(&tReq);
+    UA_TranslateBrowsePathsToNodeIdsResponse_clear(&tResp);
+    return resolved;
+}
+
+void OPCUAClient::refreshNamespaceArray() {
+    UA_ReadRequest rReq;
+    UA_ReadRequest_init(&rReq);
+    rReq.nodesToReadSize = 1;
+    rReq.nodesToRead = (UA_ReadValueId*)UA_Array_new(1, &UA_TYPES[UA_TYPES_READVALUEID]);
+    rReq.nodesToRead[0].nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY);
+    rReq.nodesToRead[0].attributeId = UA_ATTRIBUTEID_VALUE;
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    recordService(sent, rResp.responseHeader.serviceResult,
+                  encodedSize(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]),
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+
+    std::vector<std::string> current;
+    bool ok = rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD && rResp.resultsSize == 1 &&
+              rResp.results[0].hasValue &&
+              UA_Variant_hasArrayType(&rResp.results[0].value, &UA_TYPES[UA_TYPES_STRING]);
+    if (ok) {
+        const UA_Variant& v = rResp.results[0].value;
+        const UA_String* uris = static_cast<const UA_String*>(v.data);
+        for (size_t i = 0; i < v.arrayLength; i++) {
+            current.emplace_back((char*)uris[i].data, uris[i].length);
+        }
+    }
+
+    UA_ReadRequest_clear(&rReq);
+    UA_ReadResponse_clear(&rResp);
+
+    if (!ok) {
+        clearBrowseCache();
+        namespaceArray.clear();
+        return;
+    }
+
+    if (current != namespaceArray) {
+        if (namespaceSeen) {
+            std::cerr << "Server namespace array changed, resolved nodes are invalid" << std::endl;
+            namespaceGeneration.fetch_add(1, std::memory_order_relaxed);
+        }
+        clearBrowseCache();
+        namespaceArray = std::move(current);
+    }
+    namespaceSeen = true;
 }
 
 bool OPCUAClient::readDisplayName(const OPCUANode& node, std::string& displayName) const {
@@ -243,7 +931,11 @@ bool OPCUAClient::readDisplayName(const OPCUANode& node, std::string& displayNam
     rReq.nodesToRead[0].nodeId = node.getId();
     rReq.nodesToRead[0].attributeId = UA_ATTRIBUTEID_DISPLAYNAME;
     
+    auto sent = std::chrono::steady_clock::now();
     UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    recordService(sent, rResp.responseHeader.serviceResult,
+                  encodedSize(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]),
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
     
     bool success = false;
     
@@ -263,41 +955,700 @@ bool OPCUAClient::readDisplayName(const OPCUANode& node, std::string& displayNam
     return success;
 }
 
+bool OPCUAClient::readVariableAttributes(const std::vector<OPCUANode>& nodes,
+                                         std::vector<VariableAttributes>& attributes) const {
+    attributes.assign(nodes.size(), VariableAttributes{});
+    if (!client) return false;
+    return readAttributeBatch(nodes.data(), attributes.data(), nodes.size());
+}
+
+bool OPCUAClient::readAttributeBatch(const OPCUANode* nodes, VariableAttributes* attributes, size_t count) const {
+    static constexpr UA_UInt32 attributeIds[] = {
+        UA_ATTRIBUTEID_DATATYPE, UA_ATTRIBUTEID_VALUERANK, UA_ATTRIBUTEID_ACCESSLEVEL
+    };
+    constexpr size_t perNode = sizeof(attributeIds) / sizeof(attributeIds[0]);
+    if (count == 0) return true;
+
+    UA_ReadRequest rReq;
+    UA_ReadRequest_init(&rReq);
+    rReq.nodesToReadSize = count * perNode;
+    rReq.nodesToRead = (UA_ReadValueId*)UA_Array_new(rReq.nodesToReadSize, &UA_TYPES[UA_TYPES_READVALUEID]);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t a = 0; a < perNode; a++) {
+            UA_ReadValueId& id = rReq.nodesToRead[i * perNode + a];
+            UA_NodeId_copy(&nodes[i].getId(), &id.nodeId);
+            id.attributeId = attributeIds[a];
+        }
+    }
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    recordService(sent, rResp.responseHeader.serviceResult,
+                  encodedSize(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]),
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+    UA_StatusCode status = rResp.responseHeader.serviceResult;
+    bool complete = status == UA_STATUSCODE_GOOD && rResp.resultsSize == rReq.nodesToReadSize;
+
+    if (complete) {
+        for (size_t i = 0; i < count; i++) {
+            const UA_DataValue* results = &rResp.results[i * perNode];
+            VariableAttributes& out = attributes[i];
+
+            if (results[0].hasValue && UA_Variant_hasScalarType(&results[0].value, &UA_TYPES[UA_TYPES_NODEID])) {
+                // Built-in kinds Boolean..Double share their indices in UA_TYPES.
+                const UA_DataType* type = UA_findDataType((const UA_NodeId*)results[0].value.data);
+                if (type && type->typeKind <= UA_DATATYPEKIND_DOUBLE) out.type = &UA_TYPES[type->typeKind];
+            }
+            if (results[1].hasValue && UA_Variant_hasScalarType(&results[1].value, &UA_TYPES[UA_TYPES_INT32])) {
+                out.valueRank = *(const UA_Int32*)results[1].value.data;
+            }
+            if (results[2].hasValue && UA_Variant_hasScalarType(&results[2].value, &UA_TYPES[UA_TYPES_BYTE])) {
+                out.accessLevel = *(const UA_Byte*)results[2].value.data;
+            }
+        }
+    }
+
+    UA_ReadRequest_clear(&rReq);
+    UA_ReadResponse_clear(&rResp);
+
+    if (complete) return true;
+    if (status == UA_STATUSCODE_BADTOOMANYOPERATIONS && count > 1) {
+        size_t half = count / 2;
+        bool first = readAttributeBatch(nodes, attributes, half);
+        return readAttributeBatch(nodes + half, attributes + half, count - half) && first;
+    }
+    std::cerr << "Attribute read failed: " << UA_StatusCode_name(status) << std::endl;
+    return false;
+}
+
 std::vector<std::pair<bool, double>> OPCUAClient::readMultipleValues(const std::vector<OPCUANode>& nodes) const {
     std::vector<std::pair<bool, double>> results;
     if (!client || nodes.empty()) return results;
 
-    UA_ReadRequest rReq;
-    UA_ReadRequest_init(&rReq);
-    rReq.nodesToReadSize = nodes.size();
-    rReq.nodesToRead = (UA_ReadValueId*)UA_Array_new(nodes.size(), &UA_TYPES[UA_TYPES_READVALUEID]);
+    PreparedRead prepared = prepareRead(nodes);
+    results.assign(nodes.size(), {false, 0.0});
+    executeRead(prepared, results.data(), results.size());
     
+    return results;
+}
+
+PreparedRead OPCUAClient::prepareRead(const std::vector<OPCUANode>& nodes, UA_TimestampsToReturn timestamps) const {
+    PreparedRead prepared;
+    if (nodes.empty()) return prepared;
+
+    UA_ReadRequest& rReq = prepared.request;
+    rReq.nodesToRead = (UA_ReadValueId*)UA_Array_new(nodes.size(), &UA_TYPES[UA_TYPES_READVALUEID]);
+    if (!rReq.nodesToRead) return prepared;
+    rReq.nodesToReadSize = nodes.size();
+    rReq.timestampsToReturn = timestamps;
+    prepared.scalarCount = nodes.size();
+    prepared.decoders.resize(nodes.size());
+
     for (size_t i = 0; i < nodes.size(); i++) {
-        UA_ReadValueId_init(&rReq.nodesToRead[i]);
-        rReq.nodesToRead[i].nodeId = nodes[i].getId();
+        UA_NodeId_copy(&nodes[i].getId(), &rReq.nodesToRead[i].nodeId);
         rReq.nodesToRead[i].attributeId = UA_ATTRIBUTEID_VALUE;
     }
-    
-    UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
-    
+    prepared.encodedSize = UA_calcSizeBinary(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]);
+
+    return prepared;
+}
+
+PreparedRead OPCUAClient::prepareRead(const std::vector<OPCUANode>& scalars, const std::vector<OPCUANode>& arrays,
+                                      UA_TimestampsToReturn timestamps) const {
+    std::vector<OPCUANode> nodes;
+    nodes.reserve(scalars.size() + arrays.size());
+    nodes.insert(nodes.end(), scalars.begin(), scalars.end());
+    nodes.insert(nodes.end(), arrays.begin(), arrays.end());
+
+    PreparedRead prepared = prepareRead(nodes, timestamps);
+    prepared.scalarCount = std::min(scalars.size(), prepared.size());
+    return prepared;
+}
+
+size_t OPCUAClient::executeRead(const PreparedRead& prepared, std::pair<bool, double>* out, size_t outSize) const {
+    size_t count = std::min(outSize, prepared.size());
+    for (size_t i = 0; i < count; i++) {
+        out[i] = {false, 0.0};
+    }
+    if (!client || count == 0) return 0;
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, prepared.request);
+    recordService(sent, rResp.responseHeader.serviceResult, prepared.encodedSize,
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+
+    size_t good = 0;
     if (rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
-        for (size_t i = 0; i < rResp.resultsSize; i++) {
-            if (rResp.results[i].hasValue && 
-                UA_Variant_hasScalarType(&rResp.results[i].value, &UA_TYPES[UA_TYPES_DOUBLE])) {
-                double value = *(double*)rResp.results[i].value.data;
-                results.push_back({true, value});
+        size_t n = std::min(count, rResp.resultsSize);
+        for (size_t i = 0; i < n; i++) {
+            const UA_DataValue& dv = rResp.results[i];
+            if (dv.hasValue && prepared.decoders[i].decodeScalar(dv.value, out[i].second)) {
+                out[i].first = true;
+                good++;
+            }
+        }
+    }
+
+    UA_ReadResponse_clear(&rResp);
+    return good;
+}
+
+size_t OPCUAClient::executeRead(const PreparedRead& prepared, TagSample* out, size_t outSize) const {
+    return executeRead(prepared, out, outSize, nullptr, 0);
+}
+
+size_t OPCUAClient::executeRead(const PreparedRead& prepared, TagSample* out, size_t outSize,
+                                VariantBuffer* arrays, size_t arrayCount) const {
+    size_t count = std::min(outSize, prepared.scalarCount);
+    arrayCount = std::min(arrayCount, prepared.arrayCount());
+    for (size_t i = 0; i < arrayCount; i++) {
+        arrays[i].reset();
+    }
+    if (!client || count + arrayCount == 0) return 0;
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, prepared.request);
+    UA_StatusCode serviceResult = rResp.responseHeader.serviceResult;
+    recordService(sent, serviceResult, prepared.encodedSize,
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+
+    size_t good = 0;
+    size_t n = serviceResult == UA_STATUSCODE_GOOD ? std::min(count, rResp.resultsSize) : 0;
+    for (size_t i = 0; i < n; i++) {
+        if (decodeSample(rResp.results[i], prepared.decoders[i], out[i])) good++;
+    }
+    for (size_t i = n; i < count; i++) {
+        out[i].status = serviceResult != UA_STATUSCODE_GOOD ? serviceResult : UA_STATUSCODE_BADNODATA;
+    }
+    if (serviceResult == UA_STATUSCODE_GOOD) {
+        for (size_t i = 0; i < arrayCount && prepared.scalarCount + i < rResp.resultsSize; i++) {
+            UA_DataValue& dv = rResp.results[prepared.scalarCount + i];
+            if (dv.hasValue && resolveDecoder<double>(dv.value.type)) {
+                arrays[i].adopt(dv.value);
+                good++;
+            }
+        }
+    }
+
+    UA_ReadResponse_clear(&rResp);
+    return good;
+}
+
+size_t OPCUAClient::executeRead(const PreparedRead& prepared, VariantBuffer* out, size_t outSize) const {
+    size_t count = std::min(outSize, prepared.size());
+    for (size_t i = 0; i < count; i++) {
+        out[i].reset();
+    }
+    if (!client || count == 0) return 0;
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, prepared.request);
+    recordService(sent, rResp.responseHeader.serviceResult, prepared.encodedSize,
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+
+    size_t good = 0;
+    if (rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+        size_t n = std::min(count, rResp.resultsSize);
+        for (size_t i = 0; i < n; i++) {
+            UA_DataValue& dv = rResp.results[i];
+            if (dv.hasValue && resolveDecoder<double>(dv.value.type)) {
+                out[i].adopt(dv.value);
+                good++;
+            }
+        }
+    }
+
+    UA_ReadResponse_clear(&rResp);
+    return good;
+}
+
+bool OPCUAClient::readBuffer(const OPCUANode& node, VariantBuffer& buffer) const {
+    buffer.reset();
+    if (!client || !node.isValid()) return false;
+
+    PreparedRead prepared = prepareRead({node});
+    return executeRead(prepared, &buffer, 1) == 1;
+}
+
+UA_UInt32 OPCUAClient::createSubscription(double publishingIntervalMs, void* context) {
+    if (!client) return 0;
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = publishingIntervalMs;
+
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, context, nullptr, nullptr);
+
+    UA_UInt32 subscriptionId = 0;
+    if (response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+        subscriptionId = response.subscriptionId;
+    } else {
+        std::cerr << "Failed to create subscription: "
+                  << UA_StatusCode_name(response.responseHeader.serviceResult) << std::endl;
+    }
+
+    UA_CreateSubscriptionResponse_clear(&response);
+    return subscriptionId;
+}
+
+bool OPCUAClient::deleteSubscription(UA_UInt32 subscriptionId) {
+    if (!client || subscriptionId == 0) return false;
+    return UA_Client_Subscriptions_deleteSingle(client, subscriptionId) == UA_STATUSCODE_GOOD;
+}
+
+namespace {
+
+bool isFilterRejection(UA_StatusCode status) {
+    return status == UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED ||
+           status == UA_STATUSCODE_BADFILTERNOTALLOWED ||
+           status == UA_STATUSCODE_BADDEADBANDFILTERINVALID;
+}
+
+}
+
+// filters is either empty or one entry per node; entries with no deadband
+// leave the server default (status or value change). Items whose filter the
+// server rejects, typically a percent deadband on a variable without an
+// EURange, are created again without one.
+std::vector<UA_UInt32> OPCUAClient::addMonitoredItems(UA_UInt32 subscriptionId,
+                                                      const std::vector<OPCUANode>& nodes,
+                                                      double samplingIntervalMs,
+                                                      UA_Client_DataChangeNotificationCallback callback,
+                                                      const std::vector<void*>& contexts,
+                                                      const std::vector<UA_DataChangeFilter>& filters) {
+    std::vector<UA_UInt32> monitoredItemIds(nodes.size(), 0);
+    if (!client || subscriptionId == 0 || nodes.empty() || contexts.size() != nodes.size() ||
+        (!filters.empty() && filters.size() != nodes.size())) {
+        return monitoredItemIds;
+    }
+
+    std::vector<UA_MonitoredItemCreateRequest> items(nodes.size());
+    std::vector<UA_Client_DataChangeNotificationCallback> callbacks(nodes.size(), callback);
+    std::vector<void*> itemContexts(contexts);
+    std::vector<UA_DataChangeFilter> itemFilters(filters);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        items[i] = UA_MonitoredItemCreateRequest_default(nodes[i].getId());
+        items[i].requestedParameters.samplingInterval = samplingIntervalMs;
+        if (!itemFilters.empty() && itemFilters[i].deadbandType != UA_DEADBANDTYPE_NONE) {
+            UA_ExtensionObject_setValue(&items[i].requestedParameters.filter, &itemFilters[i],
+                                        &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+        }
+    }
+
+    std::vector<size_t> unfiltered;
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.itemsToCreate = items.data();
+    request.itemsToCreateSize = items.size();
+
+    UA_CreateMonitoredItemsResponse response = UA_Client_MonitoredItems_createDataChanges(
+        client, request, itemContexts.data(), callbacks.data(), nullptr);
+
+    if (response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+        for (size_t i = 0; i < response.resultsSize && i < nodes.size(); i++) {
+            if (response.results[i].statusCode == UA_STATUSCODE_GOOD) {
+                monitoredItemIds[i] = response.results[i].monitoredItemId;
+            } else if (isFilterRejection(response.results[i].statusCode) &&
+                       items[i].requestedParameters.filter.encoding != UA_EXTENSIONOBJECT_ENCODED_NOBODY) {
+                unfiltered.push_back(i);
             } else {
-                results.push_back({false, 0.0});
+                std::cerr << "Failed to monitor " << nodes[i].getBrowseName() << ": "
+                          << UA_StatusCode_name(response.results[i].statusCode) << std::endl;
             }
         }
     } else {
-        for (size_t i = 0; i < nodes.size(); i++) {
-            results.push_back({false, 0.0});
+        std::cerr << "Failed to create monitored items: "
+                  << UA_StatusCode_name(response.responseHeader.serviceResult) << std::endl;
+    }
+
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    if (!unfiltered.empty()) {
+        std::cerr << "Server rejected the deadband filter for " << unfiltered.size()
+                  << " items, monitoring them without it" << std::endl;
+
+        std::vector<OPCUANode> retryNodes;
+        std::vector<void*> retryContexts;
+        for (size_t i : unfiltered) {
+            retryNodes.push_back(nodes[i]);
+            retryContexts.push_back(contexts[i]);
+        }
+        auto retryIds = addMonitoredItems(subscriptionId, retryNodes, samplingIntervalMs, callback, retryContexts);
+        for (size_t k = 0; k < unfiltered.size(); k++) {
+            monitoredItemIds[unfiltered[k]] = retryIds[k];
         }
     }
-    
-    UA_ReadRequest_clear(&rReq);
-    UA_ReadResponse_clear(&rResp);
-    
-    return results;
-}
\ No newline at end of file
+
+    return monitoredItemIds;
+}
+
+bool OPCUAClient::runIterate(int timeoutMs) {
+    if (!client) return false;
+    expireWrites();
+    if (autoReconnect && !superviseConnection()) return false;
+    flushWrites();
+    dispatchAsync();
+    bool ok = UA_Client_run_iterate(client, static_cast<UA_UInt32>(timeoutMs)) == UA_STATUSCODE_GOOD;
+    flushWrites();
+    dispatchAsync();
+    return ok;
+}
+
+
+struct OPCUAClient::AsyncRequest {
+    OPCUAClient* owner{nullptr};
+    const PreparedRead* read{nullptr};
+    UA_WriteRequest write;
+    AsyncReadCallback onRead;
+    AsyncWriteCallback onWrite;
+    std::chrono::steady_clock::time_point issued;
+    std::chrono::steady_clock::time_point sent;
+
+    AsyncRequest() { UA_WriteRequest_init(&write); }
+    ~AsyncRequest() { UA_WriteRequest_clear(&write); }
+};
+
+bool OPCUAClient::submitAsync(AsyncRequest* request) {
+    request->owner = this;
+    request->issued = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    if (!client || asyncQueue.size() >= maxQueued) {
+        return false;
+    }
+    asyncQueue.push_back(request);
+    return true;
+}
+
+void OPCUAClient::dispatchAsync() {
+    while (client && asyncInFlight.load(std::memory_order_relaxed) < maxInFlight) {
+        AsyncRequest* request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            if (asyncQueue.empty()) break;
+            request = asyncQueue.front();
+            asyncQueue.pop_front();
+        }
+
+        UA_StatusCode status;
+        request->sent = std::chrono::steady_clock::now();
+        if (request->read) {
+            status = UA_Client_sendAsyncRequest(client, &request->read->request, &UA_TYPES[UA_TYPES_READREQUEST],
+                                                asyncServiceCallback, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                                request, nullptr);
+        } else {
+            status = UA_Client_sendAsyncRequest(client, &request->write, &UA_TYPES[UA_TYPES_WRITEREQUEST],
+                                                asyncServiceCallback, &UA_TYPES[UA_TYPES_WRITERESPONSE],
+                                                request, nullptr);
+        }
+
+        if (status == UA_STATUSCODE_GOOD) {
+            asyncInFlight.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            finishAsync(request, nullptr, status);
+        }
+    }
+}
+
+void OPCUAClient::asyncServiceCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, void* response) {
+    auto* request = static_cast<AsyncRequest*>(userdata);
+    request->owner->asyncInFlight.fetch_sub(1, std::memory_order_relaxed);
+    request->owner->finishAsync(request, response, UA_STATUSCODE_GOOD);
+}
+
+void OPCUAClient::finishAsync(AsyncRequest* request, void* response, UA_StatusCode status) {
+    auto completed = std::chrono::steady_clock::now();
+
+    if (request->read) {
+        AsyncReadResult result;
+        result.issued = request->issued;
+        result.completed = completed;
+        result.values.assign(request->read->scalarCount, {false, 0.0});
+        result.samples.assign(request->read->scalarCount, TagSample());
+        result.arrays.resize(request->read->arrayCount());
+        result.status = status;
+
+        if (response) {
+            auto* rResp = static_cast<UA_ReadResponse*>(response);
+            result.status = rResp->responseHeader.serviceResult;
+            recordService(request->sent, result.status, request->read->encodedSize,
+                          encodedSize(rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+            if (result.status == UA_STATUSCODE_GOOD) {
+                size_t n = std::min(result.values.size(), rResp->resultsSize);
+                for (size_t i = 0; i < n; i++) {
+                    TagSample& sample = result.samples[i];
+                    if (decodeSample(rResp->results[i], request->read->decoders[i], sample)) {
+                        result.values[i] = {true, sample.value};
+                    }
+                }
+                // The stack clears the response after this callback; adopting
+                // the arrays leaves it empty variants to clear.
+                size_t first = request->read->scalarCount;
+                for (size_t i = 0; i < result.arrays.size() && first + i < rResp->resultsSize; i++) {
+                    UA_DataValue& dv = rResp->results[first + i];
+                    if (dv.hasValue && resolveDecoder<double>(dv.value.type)) result.arrays[i].adopt(dv.value);
+                }
+            }
+        }
+        if (result.status != UA_STATUSCODE_GOOD) {
+            for (auto& sample : result.samples) sample.status = result.status;
+        }
+
+        if (request->onRead) request->onRead(result);
+    } else {
+        AsyncWriteResult result;
+        result.issued = request->issued;
+        result.completed = completed;
+        result.results.assign(request->write.nodesToWriteSize, status);
+        result.status = status;
+
+        if (response) {
+            const auto* wResp = static_cast<const UA_WriteResponse*>(response);
+            result.status = wResp->responseHeader.serviceResult;
+            recordService(request->sent, result.status,
+                          encodedSize(&request->write, &UA_TYPES[UA_TYPES_WRITEREQUEST]),
+                          encodedSize(wResp, &UA_TYPES[UA_TYPES_WRITERESPONSE]));
+            for (size_t i = 0; i < result.results.size(); i++) {
+                result.results[i] = result.status != UA_STATUSCODE_GOOD ? result.status
+                                  : i < wResp->resultsSize ? wResp->results[i]
+                                  : UA_STATUSCODE_BADINTERNALERROR;
+            }
+        }
+
+        if (request->onWrite) request->onWrite(result);
+    }
+
+    delete request;
+}
+
+void OPCUAClient::failQueuedAsync(UA_StatusCode status) {
+    std::deque<AsyncRequest*> queued;
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        queued.swap(asyncQueue);
+    }
+    for (AsyncRequest* request : queued) {
+        finishAsync(request, nullptr, status);
+    }
+}
+
+size_t OPCUAClient::queuedCount() const {
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    return asyncQueue.size();
+}
+
+bool OPCUAClient::readAsync(const PreparedRead& prepared, AsyncReadCallback callback) {
+    auto* request = new AsyncRequest();
+    request->read = &prepared;
+    request->onRead = std::move(callback);
+
+    if (!submitAsync(request)) {
+        delete request;
+        return false;
+    }
+    return true;
+}
+
+std::future<AsyncReadResult> OPCUAClient::readAsync(const PreparedRead& prepared) {
+    auto promise = std::make_shared<std::promise<AsyncReadResult>>();
+    std::future<AsyncReadResult> future = promise->get_future();
+
+    bool queued = readAsync(prepared, [promise](AsyncReadResult& result) {
+        promise->set_value(std::move(result));
+    });
+
+    if (!queued) {
+        AsyncReadResult rejected;
+        rejected.status = client ? UA_STATUSCODE_BADTOOMANYOPERATIONS : UA_STATUSCODE_BADNOTCONNECTED;
+        rejected.issued = rejected.completed = std::chrono::steady_clock::now();
+        promise->set_value(std::move(rejected));
+    }
+    return future;
+}
+
+bool OPCUAClient::writeAsync(const std::vector<OPCUANode>& nodes, const std::vector<double>& values,
+                             AsyncWriteCallback callback) {
+    return writeAsync(nodes, values, {}, std::move(callback));
+}
+
+bool OPCUAClient::writeAsync(const std::vector<OPCUANode>& nodes, const std::vector<double>& values,
+                             const std::vector<const UA_DataType*>& types, AsyncWriteCallback callback) {
+    if (nodes.empty() || nodes.size() != values.size()) return false;
+
+    auto* request = new AsyncRequest();
+    request->onWrite = std::move(callback);
+    request->write.nodesToWriteSize = nodes.size();
+    request->write.nodesToWrite = (UA_WriteValue*)UA_Array_new(nodes.size(), &UA_TYPES[UA_TYPES_WRITEVALUE]);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        UA_WriteValue& wv = request->write.nodesToWrite[i];
+        UA_NodeId_copy(&nodes[i].getId(), &wv.nodeId);
+        wv.attributeId = UA_ATTRIBUTEID_VALUE;
+        wv.value.hasValue = true;
+        const UA_DataType* type = i < types.size() && types[i] ? types[i] : &UA_TYPES[UA_TYPES_DOUBLE];
+        if (!encodeScalar(values[i], type, wv.value.value)) {
+            std::cerr << "Cannot write a numeric value to " << nodes[i].getBrowseName() << std::endl;
+            delete request;
+            return false;
+        }
+    }
+
+    if (!submitAsync(request)) {
+        delete request;
+        return false;
+    }
+    return true;
+}
+
+std::future<AsyncWriteResult> OPCUAClient::writeAsync(const std::vector<OPCUANode>& nodes,
+                                                      const std::vector<double>& values) {
+    auto promise = std::make_shared<std::promise<AsyncWriteResult>>();
+    std::future<AsyncWriteResult> future = promise->get_future();
+
+    bool queued = writeAsync(nodes, values, [promise](AsyncWriteResult& result) {
+        promise->set_value(std::move(result));
+    });
+
+    if (!queued) {
+        AsyncWriteResult rejected;
+        rejected.status = client ? UA_STATUSCODE_BADTOOMANYOPERATIONS : UA_STATUSCODE_BADNOTCONNECTED;
+        rejected.results.assign(nodes.size(), rejected.status);
+        rejected.issued = rejected.completed = std::chrono::steady_clock::now();
+        promise->set_value(std::move(rejected));
+    }
+    return future;
+}
+
+
+bool OPCUAClient::queueWrite(const OPCUANode& node, double value, QueuedWriteCallback callback,
+                             const UA_DataType* type) {
+    if (!node.isValid()) return false;
+    expireWrites();
+
+    auto queued = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!client) return false;
+
+    auto it = pendingWriteIndex.find(node);
+    if (it != pendingWriteIndex.end()) {
+        PendingWrite& pending = pendingWrites[it->second];
+        pending.value = value;
+        pending.type = type;
+        pending.waiters.emplace_back(queued, std::move(callback));
+        coalescedWrites.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (pendingWrites.size() >= maxPendingWrites) {
+        return false;
+    }
+
+    pendingWriteIndex.emplace(node, pendingWrites.size());
+    pendingWrites.push_back({node, value, type, {}});
+    pendingWrites.back().waiters.emplace_back(queued, std::move(callback));
+    return true;
+}
+
+size_t OPCUAClient::pendingWriteCount() const {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return pendingWrites.size();
+}
+
+void OPCUAClient::flushWrites() {
+    if (!client || !sessionUp || writeBatchInFlight.load(std::memory_order_acquire)) return;
+
+    auto batch = std::make_shared<std::vector<PendingWrite>>();
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (pendingWrites.empty()) return;
+
+        size_t n = std::min(pendingWrites.size(), maxWriteBatch);
+        batch->assign(std::make_move_iterator(pendingWrites.begin()),
+                      std::make_move_iterator(pendingWrites.begin() + n));
+        pendingWrites.erase(pendingWrites.begin(), pendingWrites.begin() + n);
+
+        pendingWriteIndex.clear();
+        for (size_t i = 0; i < pendingWrites.size(); i++) {
+            pendingWriteIndex.emplace(pendingWrites[i].node, i);
+        }
+    }
+
+    std::vector<OPCUANode> nodes;
+    std::vector<double> values;
+    std::vector<const UA_DataType*> types;
+    nodes.reserve(batch->size());
+    values.reserve(batch->size());
+    types.reserve(batch->size());
+    for (const auto& pending : *batch) {
+        nodes.push_back(pending.node);
+        values.push_back(pending.value);
+        types.push_back(pending.type);
+    }
+
+    writeBatchInFlight.store(true, std::memory_order_release);
+    bool queued = writeAsync(nodes, values, types, [this, batch](AsyncWriteResult& result) {
+        writeBatchInFlight.store(false, std::memory_order_release);
+        completeWrites(*batch, result.results, result.completed);
+    });
+
+    if (!queued) {
+        writeBatchInFlight.store(false, std::memory_order_release);
+        completeWrites(*batch, std::vector<UA_StatusCode>(batch->size(), UA_STATUSCODE_BADTOOMANYOPERATIONS),
+                       std::chrono::steady_clock::now());
+    }
+}
+
+size_t OPCUAClient::expireWrites() {
+    auto cutoff = std::chrono::steady_clock::now() - writeTimeout;
+    std::vector<PendingWrite> expired;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        auto stale = [&](const PendingWrite& p) { return p.waiters.front().first < cutoff; };
+        if (std::none_of(pendingWrites.begin(), pendingWrites.end(), stale)) return 0;
+
+        std::vector<PendingWrite> kept;
+        for (auto& pending : pendingWrites) {
+            (stale(pending) ? expired : kept).push_back(std::move(pending));
+        }
+        pendingWrites.swap(kept);
+
+        pendingWriteIndex.clear();
+        for (size_t i = 0; i < pendingWrites.size(); i++) {
+            pendingWriteIndex.emplace(pendingWrites[i].node, i);
+        }
+    }
+
+    completeWrites(expired, std::vector<UA_StatusCode>(expired.size(), UA_STATUSCODE_BADTIMEOUT),
+                   std::chrono::steady_clock::now());
+    return expired.size();
+}
+
+void OPCUAClient::failPendingWrites(UA_StatusCode status) {
+    std::vector<PendingWrite> pending;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        pending.swap(pendingWrites);
+        pendingWriteIndex.clear();
+    }
+    completeWrites(pending, std::vector<UA_StatusCode>(pending.size(), status), std::chrono::steady_clock::now());
+}
+
+void OPCUAClient::completeWrites(std::vector<PendingWrite>& batch, const std::vector<UA_StatusCode>& statuses,
+                                 std::chrono::steady_clock::time_point completed) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        auto& waiters = batch[i].waiters;
+        for (size_t j = 0; j < waiters.size(); j++) {
+            if (!waiters[j].second) continue;
+
+            QueuedWriteResult result;
+            result.status = i < statuses.size() ? statuses[i] : UA_STATUSCODE_BADINTERNALERROR;
+            result.value = batch[i].value;
+            result.coalesced = j + 1 < waiters.size();
+            result.latency = completed - waiters[j].first;
+            waiters[j].second(result);
+        }
+    }
+}
@@ -3,9 +3,22 @@
 
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_subscriptions.h>
+#include "variant_decoder.h"
+#include "backoff.h"
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 
 class OPCUANode {
@@ -32,26 +45,252 @@ public:
 };
 
 
+struct NodeIdHash {
+    size_t operator()(const OPCUANode& node) const { return UA_NodeId_hash(&node.getId()); }
+};
+
+struct NodeIdEqual {
+    bool operator()(const OPCUANode& a, const OPCUANode& b) const {
+        return UA_NodeId_equal(&a.getId(), &b.getId());
+    }
+};
+
+
+struct BrowseReference {
+    OPCUANode node;
+    UA_NodeClass nodeClass;
+    UA_UInt32 referenceType;
+    UA_UInt16 browseNamespace;
+};
+
+
+// Discovery output is in breadth-first order: a parent always precedes its
+// children, and parent is an index into the same vector.
+struct DiscoveredNode {
+    static constexpr uint32_t ROOT = UINT32_MAX;
+
+    OPCUANode node;
+    UA_NodeClass nodeClass;
+    uint32_t parent;
+    uint32_t depth;
+    std::string path;
+};
+
+// What a discovered Variable holds and how it may be accessed. type is the
+// built-in numeric type behind the node's DataType (subtypes such as Duration
+// map to their base), or nullptr for anything else: strings, structures,
+// enumerations, or a DataType this stack does not know.
+struct VariableAttributes {
+    const UA_DataType* type{nullptr};
+    UA_Int32 valueRank{UA_VALUERANK_SCALAR};
+    UA_Byte accessLevel{0};
+};
+
+// Objects are expanded, Variables are not, so their properties are skipped.
+struct DiscoveryOptions {
+    size_t nodesPerRequest{500};
+    size_t maxInFlight{4};
+    size_t maxDepth{8};
+    size_t maxNodes{1000000};
+    bool includeNamespaceZero{false};
+};
+
+
+// Nodes past scalarCount are array-valued and come back whole as
+// VariantBuffers, so scalars and arrays share one ReadRequest.
+class PreparedRead {
+private:
+    UA_ReadRequest request;
+    size_t encodedSize{0};
+    size_t scalarCount{0};
+    mutable std::vector<CachedDecoder<double>> decoders;
+
+    friend class OPCUAClient;
+
+public:
+    PreparedRead();
+    ~PreparedRead();
+
+    PreparedRead(const PreparedRead&) = delete;
+    PreparedRead& operator=(const PreparedRead&) = delete;
+
+    PreparedRead(PreparedRead&& other) noexcept;
+    PreparedRead& operator=(PreparedRead&& other) noexcept;
+
+    size_t size() const { return request.nodesToReadSize; }
+    bool empty() const { return request.nodesToReadSize == 0; }
+    size_t arrayCount() const { return size() - scalarCount; }
+};
+
+
+// One decoded DataValue. Timestamps are microseconds since the Unix epoch,
+// 0 when the server did not send them. value is only set when status is not Bad.
+struct TagSample {
+    double value{0.0};
+    UA_StatusCode status{UA_STATUSCODE_BADWAITINGFORINITIALDATA};
+    int64_t sourceTs{0};
+    int64_t serverTs{0};
+};
+
+bool decodeSample(const UA_DataValue& dv, CachedDecoder<double>& decoder, TagSample& out);
+
+
+struct AsyncReadResult {
+    UA_StatusCode status{UA_STATUSCODE_GOOD};
+    std::vector<std::pair<bool, double>> values;
+    std::vector<TagSample> samples;
+    std::vector<VariantBuffer> arrays;
+    std::chrono::steady_clock::time_point issued;
+    std::chrono::steady_clock::time_point completed;
+};
+
+struct AsyncWriteResult {
+    UA_StatusCode status{UA_STATUSCODE_GOOD};
+    std::vector<UA_StatusCode> results;
+    std::chrono::steady_clock::time_point issued;
+    std::chrono::steady_clock::time_point completed;
+};
+
+struct QueuedWriteResult {
+    UA_StatusCode status{UA_STATUSCODE_GOOD};
+    double value{0.0};
+    bool coalesced{false};
+    std::chrono::steady_clock::duration latency{};
+};
+
+// Byte counts are binary-encoded service bodies, without chunk and security
+// headers, and stay zero unless traffic stats are enabled. RTT is smoothed
+// like TCP's SRTT/RTTVAR (RFC 6298).
+struct ConnectionHealth {
+    double rttMs{0.0};
+    double rttVarMs{0.0};
+    double rttMaxMs{0.0};
+    double lastRttMs{0.0};
+    uint64_t requests{0};
+    uint64_t requestTimeouts{0};
+    uint64_t sessionTimeouts{0};
+    uint64_t serviceFaults{0};
+    uint64_t channelOpens{0};
+    uint64_t bytesSent{0};
+    uint64_t bytesReceived{0};
+    int64_t msSinceLastResponse{-1};
+
+    // Not a counter: the stack reports no token renewals, so this is how many
+    // the channels should have seen given how long each stayed open and that
+    // the stack renews at 75% of the requested lifetime. Failed or delayed
+    // renewals do not show up here.
+    uint64_t expectedChannelRenewals{0};
+};
+
+using AsyncReadCallback = std::function<void(AsyncReadResult&)>;
+using AsyncWriteCallback = std::function<void(AsyncWriteResult&)>;
+using QueuedWriteCallback = std::function<void(const QueuedWriteResult&)>;
+
+
 class OPCUAClient {
 private:
     UA_Client* client;
     std::string endpoint;
 
+    // Forward hierarchical references per browsed node; survives reconnects
+    // and is dropped only when the server's namespace array changes.
+    mutable std::mutex browseCacheMutex;
+    mutable std::unordered_map<OPCUANode, std::vector<BrowseReference>, NodeIdHash, NodeIdEqual> browseCache;
+    mutable std::atomic<uint64_t> browseRequests{0};
+    mutable std::atomic<uint64_t> translateRequests{0};
+    std::vector<std::string> namespaceArray;
+
+    // Async requests may be submitted from any thread; they are sent and
+    // completed on whichever thread calls runIterate().
+    struct AsyncRequest;
+    mutable std::mutex asyncMutex;
+    std::deque<AsyncRequest*> asyncQueue;
+    std::atomic<size_t> asyncInFlight{0};
+    size_t maxInFlight{8};
+    size_t maxQueued{1024};
+
+    bool submitAsync(AsyncRequest* request);
+    void dispatchAsync();
+    void finishAsync(AsyncRequest* request, void* response, UA_StatusCode status);
+    void failQueuedAsync(UA_StatusCode status);
+    static void asyncServiceCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, void* response);
+
+    // Setpoint queue: one pending value per node (last wins), flushed as a
+    // single WriteRequest from runIterate() with at most one batch in flight.
+    struct PendingWrite {
+        OPCUANode node;
+        double value;
+        const UA_DataType* type;
+        std::vector<std::pair<std::chrono::steady_clock::time_point, QueuedWriteCallback>> waiters;
+    };
+    mutable std::mutex writeMutex;
+    std::vector<PendingWrite> pendingWrites;
+    std::unordered_map<OPCUANode, size_t, NodeIdHash, NodeIdEqual> pendingWriteIndex;
+    std::atomic<bool> writeBatchInFlight{false};
+    std::atomic<uint64_t> coalescedWrites{0};
+    size_t maxWriteBatch{1000};
+    size_t maxPendingWrites{100000};
+    std::chrono::milliseconds writeTimeout{5000};
+
+    void flushWrites();
+    void failPendingWrites(UA_StatusCode status);
+    static void completeWrites(std::vector<PendingWrite>& batch, const std::vector<UA_StatusCode>& statuses,
+                               std::chrono::steady_clock::time_point completed);
+
+    // Reconnects are driven from runIterate() with UA_Client_connectAsync, so
+    // they happen on the thread that already owns the client and never block it.
+    bool autoReconnect{false};
+    ExponentialBackoff reconnectBackoff;
+    bool reconnectPending{false};
+    std::chrono::steady_clock::time_point nextReconnectAt;
+    std::chrono::steady_clock::time_point outageStart;
+    std::atomic<bool> sessionUp{false};
+    std::atomic<bool> reconnecting{false};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<uint64_t> sessionGeneration{0};
+    std::atomic<uint64_t> namespaceGeneration{0};
+    bool namespaceSeen{false};
+    std::atomic<int64_t> lastRecoveryMs{-1};
+
+    bool superviseConnection();
+
+    // Fed only by traffic the client already generates: service responses
+    // and the stack's state callback.
+    mutable std::mutex healthMutex;
+    mutable ConnectionHealth health;
+    mutable std::chrono::steady_clock::time_point lastResponseAt;
+    UA_SecureChannelState lastChannelState{UA_SECURECHANNELSTATE_CLOSED};
+    std::chrono::steady_clock::time_point channelOpenedAt;
+    std::chrono::milliseconds channelLifetime{0};
+    std::atomic<bool> trafficStats{false};
+
+    void installHooks();
+    void recordService(std::chrono::steady_clock::time_point sent, UA_StatusCode status,
+                       size_t sentBytes, size_t receivedBytes) const;
+    size_t encodedSize(const void* message, const UA_DataType* type) const {
+        return trafficStats.load(std::memory_order_relaxed) ? UA_calcSizeBinary(message, type) : 0;
+    }
+    uint64_t expectedRenewalsSinceOpen(std::chrono::steady_clock::time_point now) const;
+    static void stateCallback(UA_Client* client, UA_SecureChannelState channelState,
+                              UA_SessionState sessionState, UA_StatusCode connectStatus);
+
+    // Discovery keeps its own window of Browse/BrowseNext requests in flight
+    // and drives the stack directly; see discover().
+    struct DiscoveryState;
+    struct DiscoveryCall;
+    bool issueDiscovery(const std::shared_ptr<DiscoveryState>& state) const;
+    void expandDiscovered(DiscoveryState& state, uint32_t owner, const std::vector<BrowseReference>& references) const;
+    void releaseContinuationPoints(DiscoveryState& state) const;
+    static void discoveryCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, void* response);
+    bool readAttributeBatch(const OPCUANode* nodes, VariableAttributes* attributes, size_t count) const;
+
     void cleanup();
+    void refreshNamespaceArray();
     
     
     template<typename T>
     static const UA_DataType* getDataType() {
-        if constexpr (std::is_same_v<T, double>) {
-            return &UA_TYPES[UA_TYPES_DOUBLE];
-        } else if constexpr (std::is_same_v<T, int>) {
-            return &UA_TYPES[UA_TYPES_INT32];
-        } else if constexpr (std::is_same_v<T, float>) {
-            return &UA_TYPES[UA_TYPES_FLOAT];
-        } else {
-            static_assert(sizeof(T) == 0, "Unsupported type");
-            return nullptr;
-        }
+        return uaDataTypeOf<T>();
     }
 
 public:
@@ -59,31 +298,120 @@ public:
     ~OPCUAClient();
 
     
+    // Queued requests and the stack's callbacks hold this pointer, so a
+    // client never moves.
     OPCUAClient(const OPCUAClient&) = delete;
     OPCUAClient& operator=(const OPCUAClient&) = delete;
-
-    
-    OPCUAClient(OPCUAClient&& other) noexcept;
-    OPCUAClient& operator=(OPCUAClient&& other) noexcept;
+    OPCUAClient(OPCUAClient&&) = delete;
+    OPCUAClient& operator=(OPCUAClient&&) = delete;
 
     bool connect();
     void disconnect();
     bool isConnected() const;
 
+    void enableAutoReconnect(const BackoffPolicy& policy = BackoffPolicy());
+    bool isSessionUp() const { return sessionUp.load(std::memory_order_relaxed); }
+    bool isReconnecting() const { return reconnecting.load(std::memory_order_relaxed); }
+    uint64_t reconnectCount() const { return reconnects.load(std::memory_order_relaxed); }
+    uint64_t getSessionGeneration() const { return sessionGeneration.load(std::memory_order_relaxed); }
+    // Bumped when a (re)connect finds a namespace array other than the one
+    // seen before: namespace indices in NodeIds resolved earlier may now
+    // point elsewhere, so their owner has to resolve them again.
+    uint64_t getNamespaceGeneration() const { return namespaceGeneration.load(std::memory_order_relaxed); }
+    int64_t lastRecoveryTimeMs() const { return lastRecoveryMs.load(std::memory_order_relaxed); }
+
+    ConnectionHealth getHealth() const;
+    void resetHealth();
+    // Encoding every message again just to count its bytes is a second pass
+    // over each response, so byte counts are off unless asked for.
+    void setTrafficStats(bool enabled) { trafficStats = enabled; }
+
     
     OPCUANode findNodeByBrowseName(const OPCUANode& parentNode, const std::string& browseName) const;
+    std::vector<BrowseReference> getReferences(const OPCUANode& node) const;
     std::vector<OPCUANode> findDeviceComponents(const OPCUANode& deviceNode) const;
+
+    bool browseNodes(const std::vector<OPCUANode>& nodes) const;
+    bool discover(const OPCUANode& root, std::vector<DiscoveredNode>& nodes,
+                  const DiscoveryOptions& options = DiscoveryOptions()) const;
+    void clearBrowseCache();
+    size_t browseCacheSize() const;
+    uint64_t browseRequestCount() const { return browseRequests.load(std::memory_order_relaxed); }
+    const std::vector<std::string>& getNamespaceArray() const { return namespaceArray; }
+    const std::string& getEndpoint() const { return endpoint; }
+
+    std::vector<OPCUANode> translateBrowsePaths(const OPCUANode& startNode,
+                                                const std::vector<std::string>& paths,
+                                                UA_UInt16 namespaceIndex) const;
+    uint64_t translateRequestCount() const { return translateRequests.load(std::memory_order_relaxed); }
     
     
     template<typename T>
     bool readValue(const OPCUANode& node, T& value) const;
+
+    template<typename T>
+    bool readArray(const OPCUANode& node, std::vector<T>& values) const;
+
+    bool readBuffer(const OPCUANode& node, VariantBuffer& buffer) const;
     
     bool readDisplayName(const OPCUANode& node, std::string& displayName) const;
+
+    // DataType, ValueRank and AccessLevel of every node in one Read; the
+    // request is split only if the server rejects it as too large.
+    bool readVariableAttributes(const std::vector<OPCUANode>& nodes,
+                                std::vector<VariableAttributes>& attributes) const;
     
     template<typename T>
     bool writeValue(const OPCUANode& node, const T& value);
     
     std::vector<std::pair<bool, double>> readMultipleValues(const std::vector<OPCUANode>& nodes) const;
+
+    
+    PreparedRead prepareRead(const std::vector<OPCUANode>& nodes,
+                             UA_TimestampsToReturn timestamps = UA_TIMESTAMPSTORETURN_NEITHER) const;
+    PreparedRead prepareRead(const std::vector<OPCUANode>& scalars, const std::vector<OPCUANode>& arrays,
+                             UA_TimestampsToReturn timestamps) const;
+    size_t executeRead(const PreparedRead& prepared, std::pair<bool, double>* out, size_t outSize) const;
+    size_t executeRead(const PreparedRead& prepared, TagSample* out, size_t outSize) const;
+    size_t executeRead(const PreparedRead& prepared, TagSample* out, size_t outSize,
+                       VariantBuffer* arrays, size_t arrayCount) const;
+    size_t executeRead(const PreparedRead& prepared, VariantBuffer* out, size_t outSize) const;
+
+    
+    UA_UInt32 createSubscription(double publishingIntervalMs, void* context = nullptr);
+    bool deleteSubscription(UA_UInt32 subscriptionId);
+    std::vector<UA_UInt32> addMonitoredItems(UA_UInt32 subscriptionId,
+                                             const std::vector<OPCUANode>& nodes,
+                                             double samplingIntervalMs,
+                                             UA_Client_DataChangeNotificationCallback callback,
+                                             const std::vector<void*>& contexts,
+                                             const std::vector<UA_DataChangeFilter>& filters = {});
+    bool runIterate(int timeoutMs);
+
+    
+    bool readAsync(const PreparedRead& prepared, AsyncReadCallback callback);
+    std::future<AsyncReadResult> readAsync(const PreparedRead& prepared);
+    bool writeAsync(const std::vector<OPCUANode>& nodes, const std::vector<double>& values,
+                    AsyncWriteCallback callback);
+    bool writeAsync(const std::vector<OPCUANode>& nodes, const std::vector<double>& values,
+                    const std::vector<const UA_DataType*>& types, AsyncWriteCallback callback);
+    std::future<AsyncWriteResult> writeAsync(const std::vector<OPCUANode>& nodes, const std::vector<double>& values);
+
+    void setMaxInFlight(size_t requests) { maxInFlight = std::max<size_t>(requests, 1); }
+    size_t getMaxInFlight() const { return maxInFlight; }
+    size_t inFlightCount() const { return asyncInFlight.load(std::memory_order_relaxed); }
+    size_t queuedCount() const;
+
+    bool queueWrite(const OPCUANode& node, double value, QueuedWriteCallback callback = nullptr,
+                    const UA_DataType* type = nullptr);
+    size_t pendingWriteCount() const;
+    uint64_t coalescedWriteCount() const { return coalescedWrites.load(std::memory_order_relaxed); }
+    void setMaxWriteBatch(size_t writes) { maxWriteBatch = std::max<size_t>(writes, 1); }
+    // Queued writes still unsent after the timeout complete with BadTimeout.
+    // runIterate() and queueWrite() check this; a caller whose client may not
+    // be pumped (manager stopped, acquisition on a pool) calls expireWrites().
+    void setWriteTimeout(std::chrono::milliseconds timeout) { writeTimeout = timeout; }
+    size_t expireWrites();
 };
 
 
@@ -99,19 +427,18 @@ bool OPCUAClient::readValue(const OPCUANode& node, T& value) const {
     rReq.nodesToRead[0].nodeId = node.getId();
     rReq.nodesToRead[0].attributeId = UA_ATTRIBUTEID_VALUE;
     
+    auto sent = std::chrono::steady_clock::now();
     UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    recordService(sent, rResp.responseHeader.serviceResult,
+                  encodedSize(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]),
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
     
     bool success = false;
     
-    const UA_DataType* dataType = getDataType<T>();
-    if (dataType && 
-        rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+    if (rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
         rResp.resultsSize > 0 &&
-        rResp.results[0].hasValue &&
-        UA_Variant_hasScalarType(&rResp.results[0].value, dataType)) {
-        
-        value = *(T*)rResp.results[0].value.data;
-        success = true;
+        rResp.results[0].hasValue) {
+        success = decodeScalar(rResp.results[0].value, value);
     }
     
     UA_ReadRequest_clear(&rReq);
@@ -120,6 +447,42 @@ bool OPCUAClient::readValue(const OPCUANode& node, T& value) const {
     return success;
 }
 
+template<typename T>
+bool OPCUAClient::readArray(const OPCUANode& node, std::vector<T>& values) const {
+    values.clear();
+    if (!client || !node.isValid()) return false;
+
+    UA_ReadValueId item;
+    UA_ReadValueId_init(&item);
+    item.nodeId = node.getId();
+    item.attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_ReadRequest rReq;
+    UA_ReadRequest_init(&rReq);
+    rReq.nodesToReadSize = 1;
+    rReq.nodesToRead = &item;
+
+    auto sent = std::chrono::steady_clock::now();
+    UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    recordService(sent, rResp.responseHeader.serviceResult,
+                  encodedSize(&rReq, &UA_TYPES[UA_TYPES_READREQUEST]),
+                  encodedSize(&rResp, &UA_TYPES[UA_TYPES_READRESPONSE]));
+
+    bool success = false;
+    if (rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+        rResp.resultsSize > 0 &&
+        rResp.results[0].hasValue &&
+        resolveDecoder<T>(rResp.results[0].value.type)) {
+        const UA_Variant& v = rResp.results[0].value;
+        values.resize(UA_Variant_isScalar(&v) ? 1 : v.arrayLength);
+        values.resize(decodeVariant(v, values.data(), values.size()));
+        success = true;
+    }
+
+    UA_ReadResponse_clear(&rResp);
+    return success;
+}
+
 template<typename T>
 bool OPCUAClient::writeValue(const OPCUANode& node, const T& value) {
     if (!client || !node.isValid()) return false;
@@ -140,7 +503,11 @@ bool OPCUAClient::writeValue(const OPCUANode& node, const T& value) {
     
     UA_Variant_setScalarCopy(&wReq.nodesToWrite[0].value.value, &value, dataType);
     
+    auto sent = std::chrono::steady_clock::now();
     UA_WriteResponse wResp = UA_Client_Service_write(client, wReq);
+    recordService(sent, wResp.responseHeader.serviceResult,
+                  encodedSize(&wReq, &UA_TYPES[UA_TYPES_WRITEREQUEST]),
+                  encodedSize(&wResp, &UA_TYPES[UA_TYPES_WRITERESPONSE]));
     
     bool success = (wResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
                    wResp.resultsSize > 0 &&
@@ -0,0 +1,442 @@
+#include "recorder.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char SEGMENT_MAGIC[8] = {'K', 'U', 'R', 'S', 'R', 'E', 'C', '1'};
+    const uint32_t SEGMENT_VERSION = 1;
+    const char* TAGS_FILE = "tags.txt";
+
+    std::string segmentFileName(uint32_t sequence) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "segment_%08u.krec", sequence);
+        return name;
+    }
+
+    bool parseSegmentSequence(const std::string& fileName, uint32_t& sequence) {
+        unsigned value = 0;
+        char tail[8] = {};
+        if (std::sscanf(fileName.c_str(), "segment_%8u.%5s", &value, tail) == 2 &&
+            std::strcmp(tail, "krec") == 0) {
+            sequence = value;
+            return true;
+        }
+        return false;
+    }
+
+    // "<id>\t<name>"; ids are dense, so anything past MAX_TAG_ID is corrupt.
+    const uint32_t MAX_TAG_ID = 1u << 24;
+
+    bool parseTagLine(const std::string& line, uint32_t& id, std::string& name) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0) return false;
+        auto [end, ec] = std::from_chars(line.data(), line.data() + tab, id);
+        if (ec != std::errc() || end != line.data() + tab || id >= MAX_TAG_ID) return false;
+        name = line.substr(tab + 1);
+        return true;
+    }
+
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+
+
+#ifdef _WIN32
+MappedSegment::MappedSegment()
+    : data(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {}
+#else
+MappedSegment::MappedSegment() : data(nullptr), size(0), fd(-1) {}
+#endif
+
+MappedSegment::~MappedSegment() {
+    close();
+}
+
+bool MappedSegment::create(const std::string& path, size_t bytes) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    uint64_t fullSize = bytes;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(fullSize >> 32),
+                                        static_cast<DWORD>(fullSize & 0xFFFFFFFFu), nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = view;
+#else
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) return false;
+
+    if (posix_fallocate(file, 0, static_cast<off_t>(bytes)) != 0 &&
+        ftruncate(file, static_cast<off_t>(bytes)) != 0) {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    data = view;
+#endif
+
+    size = bytes;
+    return true;
+}
+
+void MappedSegment::flush() {
+    if (!data) return;
+#ifdef _WIN32
+    FlushViewOfFile(data, 0);
+#else
+    msync(data, size, MS_ASYNC);
+#endif
+}
+
+void MappedSegment::close() {
+    if (!data) return;
+
+#ifdef _WIN32
+    FlushViewOfFile(data, 0);
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    msync(data, size, MS_SYNC);
+    munmap(data, size);
+    ::close(fd);
+    fd = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
+
+
+
+Recorder::Recorder(const RecorderConfig& config)
+    : config(config)
+    , queue(config.queueCapacity)
+    , header(nullptr)
+    , records(nullptr)
+    , segmentSequence(0) {}
+
+Recorder::~Recorder() {
+    stop();
+}
+
+bool Recorder::start() {
+    if (running) return true;
+
+    if (config.segmentBytes < sizeof(SegmentHeader) + sizeof(SampleRecord)) {
+        std::cerr << "Recorder segment size is too small" << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(config.directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create recording directory " << config.directory
+                  << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    segmentSequence = 0;
+    for (const auto& entry : fs::directory_iterator(config.directory, ec)) {
+        uint32_t sequence = 0;
+        if (parseSegmentSequence(entry.path().filename().string(), sequence)) {
+            segmentSequence = std::max(segmentSequence, sequence + 1);
+        }
+    }
+
+    // Segments from earlier runs stay in the directory and are read back
+    // with this tags.txt, so their ids must keep naming the same tags.
+    {
+        std::lock_guard<std::mutex> lock(tagMutex);
+        if (tagNames.empty()) {
+            loadTagNames();
+        } else {
+            saveTagNames();
+        }
+    }
+
+    running = true;
+    writerThread = std::thread(&Recorder::writerFunction, this);
+    return true;
+}
+
+void Recorder::stop() {
+    if (!running) return;
+
+    running = false;
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+// Called from the acquisition thread; tags.txt is extended by the writer
+// thread, one line per new tag.
+uint32_t Recorder::registerTag(const std::string& name) {
+    std::lock_guard<std::mutex> lock(tagMutex);
+
+    auto [it, inserted] = tagIndex.emplace(name, static_cast<uint32_t>(tagNames.size()));
+    if (inserted) {
+        tagNames.push_back(name);
+        tagsPending.store(true, std::memory_order_release);
+    }
+    return it->second;
+}
+
+void Recorder::saveTagNames() {
+    std::ofstream out(fs::path(config.directory) / TAGS_FILE, std::ios::trunc);
+    for (size_t i = 0; i < tagNames.size(); i++) {
+        out << i << '\t' << tagNames[i] << '\n';
+    }
+    savedTagCount = tagNames.size();
+    tagsPending.store(false, std::memory_order_relaxed);
+}
+
+void Recorder::loadTagNames() {
+    std::ifstream in(fs::path(config.directory) / TAGS_FILE);
+    std::string line;
+    uint32_t id = 0;
+    std::string name;
+    while (std::getline(in, line)) {
+        if (!parseTagLine(line, id, name)) {
+            std::cerr << "Skipping malformed line in " << TAGS_FILE << ": " << line << std::endl;
+            continue;
+        }
+        if (tagNames.size() <= id) tagNames.resize(id + 1);
+        tagNames[id] = name;
+    }
+
+    tagIndex.clear();
+    for (size_t i = 0; i < tagNames.size(); i++) {
+        if (!tagNames[i].empty()) tagIndex.emplace(tagNames[i], static_cast<uint32_t>(i));
+    }
+    savedTagCount = tagNames.size();
+    tagsPending.store(false, std::memory_order_relaxed);
+}
+
+void Recorder::appendTagNames() {
+    if (!tagsPending.exchange(false, std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> lock(tagMutex);
+    std::ofstream out(fs::path(config.directory) / TAGS_FILE, std::ios::app);
+    for (; savedTagCount < tagNames.size(); savedTagCount++) {
+        out << savedTagCount << '\t' << tagNames[savedTagCount] << '\n';
+    }
+}
+
+bool Recorder::openSegment() {
+    std::string path = (fs::path(config.directory) / segmentFileName(segmentSequence++)).string();
+    if (!segment.create(path, config.segmentBytes)) {
+        std::cerr << "Failed to create recording segment " << path << std::endl;
+        header = nullptr;
+        records = nullptr;
+        return false;
+    }
+
+    header = reinterpret_cast<SegmentHeader*>(segment.bytes());
+    records = reinterpret_cast<SampleRecord*>(segment.bytes() + sizeof(SegmentHeader));
+
+    std::memset(header, 0, sizeof(SegmentHeader));
+    std::memcpy(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    header->version = SEGMENT_VERSION;
+    header->recordSize = sizeof(SampleRecord);
+    header->createdUs = nowMicros();
+    header->capacity = (config.segmentBytes - sizeof(SegmentHeader)) / sizeof(SampleRecord);
+
+    segmentOpened = std::chrono::steady_clock::now();
+    return true;
+}
+
+void Recorder::closeSegment() {
+    if (!segment.isOpen()) return;
+    segment.close();
+    header = nullptr;
+    records = nullptr;
+}
+
+void Recorder::writeBatch(const SampleRecord* batch, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!header || header->recordCount >= header->capacity) {
+            closeSegment();
+            if (!openSegment()) {
+                droppedRecords.fetch_add(count - i, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        const SampleRecord& rec = batch[i];
+        records[header->recordCount] = rec;
+        if (header->recordCount == 0 || rec.timestampUs < header->firstTimestampUs) {
+            header->firstTimestampUs = rec.timestampUs;
+        }
+        if (header->recordCount == 0 || rec.timestampUs > header->lastTimestampUs) {
+            header->lastTimestampUs = rec.timestampUs;
+        }
+        header->recordCount++;
+    }
+
+    writtenRecords.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Recorder::writerFunction() {
+    std::vector<SampleRecord> batch(4096);
+    auto lastFlush = std::chrono::steady_clock::now();
+
+    while (running || queue.sizeApprox() > 0) {
+        appendTagNames();
+        size_t count = queue.popBatch(batch.data(), batch.size());
+        auto now = std::chrono::steady_clock::now();
+
+        if (header && now - segmentOpened >= config.maxSegmentDuration) {
+            closeSegment();
+        }
+
+        if (count > 0) {
+            writeBatch(batch.data(), count);
+        }
+
+        if (now - lastFlush >= std::chrono::seconds(1)) {
+            segment.flush();
+            lastFlush = now;
+        }
+
+        if (count < batch.size() / 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    appendTagNames();
+    closeSegment();
+}
+
+
+
+bool RecordingReader::open(const std::string& dir) {
+    directory = dir;
+    segmentPaths.clear();
+    tagNames.clear();
+
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec)) {
+        std::cerr << "Recording directory not found: " << dir << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> segments;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        uint32_t sequence = 0;
+        if (parseSegmentSequence(entry.path().filename().string(), sequence)) {
+            segments.push_back({sequence, entry.path().string()});
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    for (const auto& s : segments) {
+        segmentPaths.push_back(s.second);
+    }
+
+    std::ifstream tags(fs::path(dir) / TAGS_FILE);
+    std::string line;
+    uint32_t id = 0;
+    std::string name;
+    while (std::getline(tags, line)) {
+        if (!parseTagLine(line, id, name)) {
+            std::cerr << "Skipping malformed line in " << TAGS_FILE << ": " << line << std::endl;
+            continue;
+        }
+        if (tagNames.size() <= id) tagNames.resize(id + 1);
+        tagNames[id] = name;
+    }
+
+    return true;
+}
+
+std::string RecordingReader::tagName(uint32_t tagId) const {
+    if (tagId < tagNames.size() && !tagNames[tagId].empty()) {
+        return tagNames[tagId];
+    }
+    return "tag" + std::to_string(tagId);
+}
+
+size_t RecordingReader::scan(int64_t fromUs, int64_t toUs,
+                             const std::function<void(const SampleRecord&)>& callback) const {
+    size_t matched = 0;
+    std::vector<SampleRecord> chunk(4096);
+
+    for (const auto& path : segmentPaths) {
+        std::ifstream in(path, std::ios::binary);
+        SegmentHeader h{};
+        if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) continue;
+
+        if (std::memcmp(h.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+            h.recordSize != sizeof(SampleRecord)) {
+            std::cerr << "Skipping unrecognised segment " << path << std::endl;
+            continue;
+        }
+
+        if (h.recordCount == 0 || h.lastTimestampUs < fromUs || h.firstTimestampUs > toUs) {
+            continue;
+        }
+
+        uint64_t remaining = h.recordCount;
+        while (remaining > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+            if (!in.read(reinterpret_cast<char*>(chunk.data()), n * sizeof(SampleRecord))) break;
+            for (size_t i = 0; i < n; i++) {
+                if (chunk[i].timestampUs >= fromUs && chunk[i].timestampUs <= toUs) {
+                    callback(chunk[i]);
+                    matched++;
+                }
+            }
+            remaining -= n;
+        }
+    }
+
+    return matched;
+}
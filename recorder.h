@@ -0,0 +1,148 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+struct SampleRecord {
+    int64_t timestampUs;
+    double value;
+    uint32_t tagId;
+    uint32_t quality;
+};
+static_assert(sizeof(SampleRecord) == 24, "SampleRecord must stay fixed-width");
+
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t createdUs;
+    uint64_t recordCount;
+    int64_t firstTimestampUs;
+    int64_t lastTimestampUs;
+    uint64_t capacity;
+    char reserved[8];
+};
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must stay 64 bytes");
+
+
+class MappedSegment {
+private:
+    void* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+public:
+    MappedSegment();
+    ~MappedSegment();
+
+    MappedSegment(const MappedSegment&) = delete;
+    MappedSegment& operator=(const MappedSegment&) = delete;
+
+    bool create(const std::string& path, size_t bytes);
+    void flush();
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    char* bytes() const { return static_cast<char*>(data); }
+    size_t getSize() const { return size; }
+};
+
+
+struct RecorderConfig {
+    std::string directory = "recordings";
+    size_t segmentBytes = 64 * 1024 * 1024;
+    std::chrono::seconds maxSegmentDuration{3600};
+    size_t queueCapacity = 1 << 16;
+};
+
+
+class Recorder {
+private:
+    RecorderConfig config;
+    SpscQueue<SampleRecord> queue;
+
+    std::thread writerThread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> droppedRecords{0};
+    std::atomic<uint64_t> writtenRecords{0};
+
+    std::mutex tagMutex;
+    std::vector<std::string> tagNames;
+    std::unordered_map<std::string, uint32_t> tagIndex;
+    size_t savedTagCount{0};
+    std::atomic<bool> tagsPending{false};
+
+    MappedSegment segment;
+    SegmentHeader* header;
+    SampleRecord* records;
+    uint32_t segmentSequence;
+    std::chrono::steady_clock::time_point segmentOpened;
+
+    void writerFunction();
+    bool openSegment();
+    void closeSegment();
+    void writeBatch(const SampleRecord* batch, size_t count);
+    void saveTagNames();
+    void loadTagNames();
+    void appendTagNames();
+
+public:
+    explicit Recorder(const RecorderConfig& config = RecorderConfig());
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    uint32_t registerTag(const std::string& name);
+
+
+    bool record(uint32_t tagId, int64_t timestampUs, double value, uint32_t quality = 0) {
+        if (!queue.tryPush({timestampUs, value, tagId, quality})) {
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t droppedCount() const { return droppedRecords.load(std::memory_order_relaxed); }
+    uint64_t writtenCount() const { return writtenRecords.load(std::memory_order_relaxed); }
+};
+
+
+class RecordingReader {
+private:
+    std::string directory;
+    std::vector<std::string> segmentPaths;
+    std::vector<std::string> tagNames;
+
+public:
+    bool open(const std::string& directory);
+
+    const std::vector<std::string>& getTagNames() const { return tagNames; }
+    const std::vector<std::string>& getSegments() const { return segmentPaths; }
+    std::string tagName(uint32_t tagId) const;
+
+    size_t scan(int64_t fromUs, int64_t toUs, const std::function<void(const SampleRecord&)>& callback) const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "recorder.h"
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: KursovayaDump <recording-dir> [fromUs] [toUs]" << std::endl;
+        std::cerr << "Timestamps are microseconds since the Unix epoch." << std::endl;
+        return 1;
+    }
+
+    int64_t fromUs = std::numeric_limits<int64_t>::min();
+    int64_t toUs = std::numeric_limits<int64_t>::max();
+
+    try {
+        if (argc > 2) fromUs = std::stoll(argv[2]);
+        if (argc > 3) toUs = std::stoll(argv[3]);
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid time range: " << e.what() << std::endl;
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+
+    std::cout << "timestamp_us,tag,value,quality\n";
+    std::cout << std::setprecision(17);
+
+    size_t count = reader.scan(fromUs, toUs, [&](const SampleRecord& rec) {
+        std::cout << rec.timestampUs << ',' << reader.tagName(rec.tagId) << ','
+                  << rec.value << ',' << rec.quality << '\n';
+    });
+
+    std::cerr << count << " records from " << reader.getSegments().size() << " segments" << std::endl;
+    return 0;
+}
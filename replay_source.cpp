@@ -0,0 +1,68 @@
+#include "replay_source.h"
+#include <algorithm>
+#include <iostream>
+
+
+
+ReplaySource::ReplaySource()
+    : speed(1.0), loop(false), position(0), replayed(0) {}
+
+bool ReplaySource::load(const std::string& dir, int64_t fromUs, int64_t toUs) {
+    RecordingReader reader;
+    if (!reader.open(dir)) {
+        return false;
+    }
+
+    directory = dir;
+    tagNames = reader.getTagNames();
+    samples.clear();
+
+    reader.scan(fromUs, toUs, [this](const SampleRecord& rec) {
+        samples.push_back(rec);
+    });
+
+    std::stable_sort(samples.begin(), samples.end(), [](const SampleRecord& a, const SampleRecord& b) {
+        return a.timestampUs < b.timestampUs;
+    });
+
+    position = 0;
+    replayed = 0;
+
+    if (samples.empty()) {
+        std::cerr << "Recording " << dir << " has no samples in the requested range" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void ReplaySource::rewind(std::chrono::steady_clock::time_point now) {
+    position = 0;
+    startTime = now;
+}
+
+size_t ReplaySource::advance(std::chrono::steady_clock::time_point now, size_t maxBatch,
+                             const std::function<void(const SampleRecord&)>& apply) {
+    if (finished()) return 0;
+
+    size_t applied = 0;
+
+    if (speed <= 0.0) {
+        while (position < samples.size() && applied < maxBatch) {
+            apply(samples[position++]);
+            applied++;
+        }
+    } else {
+        double elapsedUs = std::chrono::duration<double, std::micro>(now - startTime).count();
+        int64_t replayClockUs = samples.front().timestampUs + static_cast<int64_t>(elapsedUs * speed);
+
+        while (position < samples.size() && applied < maxBatch &&
+               samples[position].timestampUs <= replayClockUs) {
+            apply(samples[position++]);
+            applied++;
+        }
+    }
+
+    replayed += applied;
+    return applied;
+}
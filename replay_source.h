@@ -0,0 +1,49 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include "recorder.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+class ReplaySource {
+private:
+    std::string directory;
+    std::vector<std::string> tagNames;
+    std::vector<SampleRecord> samples;
+
+    double speed;
+    bool loop;
+
+    size_t position;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t replayed;
+
+public:
+    ReplaySource();
+
+    bool load(const std::string& directory,
+              int64_t fromUs = std::numeric_limits<int64_t>::min(),
+              int64_t toUs = std::numeric_limits<int64_t>::max());
+
+    void setSpeed(double factor) { speed = factor; }
+    double getSpeed() const { return speed; }
+    void setLoop(bool enabled) { loop = enabled; }
+    bool isLooping() const { return loop; }
+
+    void rewind(std::chrono::steady_clock::time_point now);
+    size_t advance(std::chrono::steady_clock::time_point now, size_t maxBatch,
+                   const std::function<void(const SampleRecord&)>& apply);
+    bool finished() const { return position >= samples.size(); }
+
+    const std::string& getDirectory() const { return directory; }
+    const std::vector<std::string>& getTagNames() const { return tagNames; }
+    size_t sampleCount() const { return samples.size(); }
+    uint64_t replayedCount() const { return replayed; }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+
+template<typename T>
+class SeqLock {
+private:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type");
+
+    static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[WordCount];
+
+public:
+    SeqLock() {
+        for (auto& w : words) w.store(0, std::memory_order_relaxed);
+        store(T{});
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+
+    void store(const T& value) {
+        uint64_t buffer[WordCount] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WordCount; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+
+    bool tryLoad(T& out) const {
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;
+
+        uint64_t buffer[WordCount];
+        for (size_t i = 0; i < WordCount; i++) {
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = sequence.load(std::memory_order_relaxed);
+        if (before != after) return false;
+
+        std::memcpy(&out, buffer, sizeof(T));
+        return true;
+    }
+
+    T load() const {
+        T value;
+        for (int spins = 0; !tryLoad(value); spins++) {
+            if (spins > 64) std::this_thread::yield();
+        }
+        return value;
+    }
+
+    uint64_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "server_registry.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+
+
+ServerRegistry::ServerRegistry(TagStore& store, const std::vector<std::string>& tagPaths, UA_UInt16 browseNamespace)
+    : store(store), tagPaths(tagPaths), browseNamespace(browseNamespace) {}
+
+ServerRegistry::~ServerRegistry() {
+    stop();
+}
+
+uint32_t ServerRegistry::addServer(const std::string& name, const std::string& url, int intervalMs) {
+    if (running) {
+        std::cerr << "Servers must be added before the registry is started" << std::endl;
+        return UINT32_MAX;
+    }
+
+    auto endpoint = std::make_unique<Endpoint>();
+    endpoint->id = static_cast<uint32_t>(endpoints.size());
+    endpoint->name = name;
+    endpoint->url = url;
+    endpoint->interval = std::chrono::milliseconds(std::max(intervalMs, 1));
+
+    BackoffPolicy policy;
+    policy.initialDelay = std::max(endpoint->interval, policy.initialDelay);
+    endpoint->backoff = ExponentialBackoff(policy);
+
+    for (const auto& path : tagPaths) {
+        endpoint->slots.push_back(store.registerTag(endpoint->id, path));
+    }
+
+    endpoints.push_back(std::move(endpoint));
+    return endpoints.back()->id;
+}
+
+void ServerRegistry::start() {
+    if (running || endpoints.empty()) return;
+
+    running = true;
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < endpoints.size(); i++) {
+        Endpoint& endpoint = *endpoints[i];
+        auto phase = endpoint.interval * static_cast<int64_t>(i) / static_cast<int64_t>(endpoints.size());
+        endpoint.worker = std::thread(&ServerRegistry::workerFunction, this, std::ref(endpoint), now + phase);
+    }
+}
+
+void ServerRegistry::stop() {
+    if (!running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        running = false;
+    }
+    stopRequested.notify_all();
+
+    for (auto& endpoint : endpoints) {
+        if (endpoint->worker.joinable()) endpoint->worker.join();
+    }
+}
+
+bool ServerRegistry::sleepUntil(std::chrono::steady_clock::time_point at) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    return !stopRequested.wait_until(lock, at, [this] { return !running; });
+}
+
+// The client belongs to this thread from connect to disconnect.
+void ServerRegistry::workerFunction(Endpoint& endpoint, std::chrono::steady_clock::time_point due) {
+    while (sleepUntil(due)) {
+        due = runCycle(endpoint, due);
+    }
+    dropConnection(endpoint);
+}
+
+std::chrono::steady_clock::time_point ServerRegistry::runCycle(Endpoint& endpoint,
+                                                               std::chrono::steady_clock::time_point due) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (!endpoint.connected) {
+        if (connectEndpoint(endpoint)) {
+            return start + endpoint.interval;
+        }
+        return start + endpoint.backoff.next();
+    }
+
+    endpoint.client->executeRead(endpoint.read, endpoint.samples.data(), endpoint.samples.size());
+
+    if (!endpoint.client->isConnected()) {
+        std::cerr << "Lost connection to " << endpoint.name << " (" << endpoint.url << ")" << std::endl;
+        dropConnection(endpoint);
+        endpoint.failures++;
+        return start + endpoint.backoff.next();
+    }
+
+    int64_t clientUs = nowMicros();
+    for (size_t i = 0; i < endpoint.samples.size(); i++) {
+        const TagSample& sample = endpoint.samples[i];
+        int64_t timestampUs = sample.sourceTs ? sample.sourceTs : clientUs;
+        if (UA_StatusCode_isBad(sample.status)) {
+            endpoint.readSlots[i]->invalidate(timestampUs, sample.status);
+        } else {
+            endpoint.readSlots[i]->publish(timestampUs, sample.value, sample.status);
+        }
+    }
+
+    endpoint.cycles.fetch_add(1, std::memory_order_relaxed);
+    totalCycles.fetch_add(1, std::memory_order_relaxed);
+
+    auto nextDue = due + endpoint.interval;
+    if (nextDue <= std::chrono::steady_clock::now()) {
+        lateCycles.fetch_add(1, std::memory_order_relaxed);
+        nextDue = std::chrono::steady_clock::now() + endpoint.interval;
+    }
+    return nextDue;
+}
+
+bool ServerRegistry::connectEndpoint(Endpoint& endpoint) {
+    connectAttempts.fetch_add(1, std::memory_order_relaxed);
+
+    endpoint.client = std::make_unique<OPCUAClient>(endpoint.url);
+    if (!endpoint.client->connect()) {
+        endpoint.client.reset();
+        endpoint.failures++;
+        return false;
+    }
+
+    OPCUANode objectsFolder(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), "Objects", "Objects Folder");
+    std::vector<OPCUANode> resolved = endpoint.client->translateBrowsePaths(objectsFolder, tagPaths, browseNamespace);
+
+    std::vector<OPCUANode> nodes;
+    endpoint.readSlots.clear();
+    for (size_t i = 0; i < resolved.size(); i++) {
+        if (resolved[i].isValid()) {
+            nodes.push_back(resolved[i]);
+            endpoint.readSlots.push_back(endpoint.slots[i]);
+        }
+    }
+
+    if (nodes.empty()) {
+        std::cerr << "No tags resolved on " << endpoint.name << " (" << endpoint.url << ")" << std::endl;
+        endpoint.client->disconnect();
+        endpoint.client.reset();
+        endpoint.failures++;
+        return false;
+    }
+
+    endpoint.read = endpoint.client->prepareRead(nodes, UA_TIMESTAMPSTORETURN_SOURCE);
+    endpoint.samples.assign(nodes.size(), TagSample());
+    endpoint.resolvedTags = nodes.size();
+    endpoint.backoff.reset();
+    endpoint.failures = 0;
+    endpoint.connected = true;
+    return true;
+}
+
+void ServerRegistry::dropConnection(Endpoint& endpoint) {
+    endpoint.connected = false;
+    endpoint.resolvedTags = 0;
+    if (endpoint.client) {
+        endpoint.client->disconnect();
+        endpoint.client.reset();
+    }
+    for (TagStore::Slot* slot : endpoint.slots) {
+        slot->invalidate(nowMicros(), UA_STATUSCODE_BADNOTCONNECTED);
+    }
+}
+
+ServerStatus ServerRegistry::getStatus(uint32_t id) const {
+    ServerStatus status;
+    if (id >= endpoints.size()) return status;
+
+    const Endpoint& endpoint = *endpoints[id];
+    status.id = endpoint.id;
+    status.name = endpoint.name;
+    status.url = endpoint.url;
+    status.connected = endpoint.connected;
+    status.failures = endpoint.failures;
+    status.cycles = endpoint.cycles.load(std::memory_order_relaxed);
+    status.resolvedTags = endpoint.resolvedTags;
+    return status;
+}
+
+RegistryStats ServerRegistry::getStats() const {
+    RegistryStats stats;
+    stats.cycles = totalCycles.load(std::memory_order_relaxed);
+    stats.lateCycles = lateCycles.load(std::memory_order_relaxed);
+    stats.connectAttempts = connectAttempts.load(std::memory_order_relaxed);
+    stats.workerThreads = running ? endpoints.size() : 0;
+    for (const auto& endpoint : endpoints) {
+        if (endpoint->connected) stats.connectedServers++;
+    }
+    return stats;
+}
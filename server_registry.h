@@ -0,0 +1,100 @@
+#ifndef SERVER_REGISTRY_H
+#define SERVER_REGISTRY_H
+
+#include "opcua_client.h"
+#include "tag_store.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct ServerStatus {
+    uint32_t id{0};
+    std::string name;
+    std::string url;
+    bool connected{false};
+    int failures{0};
+    size_t resolvedTags{0};
+    uint64_t cycles{0};
+};
+
+struct RegistryStats {
+    uint64_t cycles{0};
+    uint64_t lateCycles{0};
+    uint64_t connectAttempts{0};
+    size_t connectedServers{0};
+    size_t workerThreads{0};
+};
+
+
+// Every server has its own acquisition worker and state (client, prepared
+// read, reconnect backoff), so a dead or slow server only delays itself:
+// connecting, resolving and reading block nothing but that server's thread.
+// Start times are staggered across the interval so the load stays flat with
+// 100+ servers.
+class ServerRegistry {
+private:
+    struct Endpoint {
+        uint32_t id{0};
+        std::string name;
+        std::string url;
+        std::chrono::milliseconds interval{100};
+        std::thread worker;
+
+        std::unique_ptr<OPCUAClient> client;
+        PreparedRead read;
+        std::vector<TagSample> samples;
+        std::vector<TagStore::Slot*> slots;
+        std::vector<TagStore::Slot*> readSlots;
+
+        ExponentialBackoff backoff;
+        std::atomic<bool> connected{false};
+        std::atomic<int> failures{0};
+        std::atomic<size_t> resolvedTags{0};
+        std::atomic<uint64_t> cycles{0};
+    };
+
+    TagStore& store;
+    std::vector<std::string> tagPaths;
+    UA_UInt16 browseNamespace;
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+
+    std::mutex stopMutex;
+    std::condition_variable stopRequested;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> totalCycles{0};
+    std::atomic<uint64_t> lateCycles{0};
+    std::atomic<uint64_t> connectAttempts{0};
+
+    void workerFunction(Endpoint& endpoint, std::chrono::steady_clock::time_point due);
+    bool sleepUntil(std::chrono::steady_clock::time_point at);
+    std::chrono::steady_clock::time_point runCycle(Endpoint& endpoint, std::chrono::steady_clock::time_point due);
+    bool connectEndpoint(Endpoint& endpoint);
+    void dropConnection(Endpoint& endpoint);
+
+public:
+    ServerRegistry(TagStore& store, const std::vector<std::string>& tagPaths, UA_UInt16 browseNamespace = 1);
+    ~ServerRegistry();
+
+    ServerRegistry(const ServerRegistry&) = delete;
+    ServerRegistry& operator=(const ServerRegistry&) = delete;
+
+    uint32_t addServer(const std::string& name, const std::string& url, int intervalMs = 100);
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    size_t serverCount() const { return endpoints.size(); }
+    ServerStatus getStatus(uint32_t id) const;
+    RegistryStats getStats() const;
+};
+
+#endif
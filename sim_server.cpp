@@ -0,0 +1,308 @@
+#include "sim_server.h"
+#include "device_schema.h"
+#include <open62541/server_config_default.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string_view>
+
+namespace {
+    const UA_UInt16 SIM_NS = 1;
+
+    // Device n of BUILTIN_DEVICES is (n + 1) * 1000 and its tags are numbered
+    // from there in BUILTIN_TAGS order; 0 for a tag missing from the table.
+    constexpr UA_UInt32 builtinDeviceNodeId(size_t device) {
+        return static_cast<UA_UInt32>((device + 1) * 1000);
+    }
+
+    constexpr UA_UInt32 builtinNodeId(size_t tag) {
+        if (tag >= BUILTIN_TAG_COUNT) return 0;
+
+        size_t device = 0;
+        while (BUILTIN_DEVICES[device].name != BUILTIN_TAGS[tag].device) device++;
+
+        UA_UInt32 id = builtinDeviceNodeId(device);
+        for (size_t t = 0; t <= tag; t++) {
+            if (BUILTIN_TAGS[t].device == BUILTIN_TAGS[tag].device) id++;
+        }
+        return id;
+    }
+
+    constexpr UA_UInt32 builtinNodeId(std::string_view device, std::string_view name) {
+        return builtinNodeId(builtinTagIndex(device, name));
+    }
+
+    constexpr UA_UInt32 MULTIMETER_VOLTAGE = builtinNodeId("Multimeter", "Voltage");
+    constexpr UA_UInt32 MULTIMETER_CURRENT = builtinNodeId("Multimeter", "Current");
+    constexpr UA_UInt32 MULTIMETER_RESISTANCE = builtinNodeId("Multimeter", "Resistance");
+    constexpr UA_UInt32 MULTIMETER_POWER = builtinNodeId("Multimeter", "Power");
+
+    constexpr UA_UInt32 MACHINE_RPM = builtinNodeId("Machine", "FlywheelRPM");
+    constexpr UA_UInt32 MACHINE_POWER = builtinNodeId("Machine", "Power");
+    constexpr UA_UInt32 MACHINE_VOLTAGE = builtinNodeId("Machine", "Voltage");
+    constexpr UA_UInt32 MACHINE_ENERGY = builtinNodeId("Machine", "EnergyConsumption");
+    constexpr UA_UInt32 MACHINE_TARGET_RPM = builtinNodeId("Machine", "TargetRPM");
+    constexpr UA_UInt32 MACHINE_CONTROL_MODE = builtinNodeId("Machine", "RPMControlMode");
+
+    constexpr UA_UInt32 COMPUTER_FAN1 = builtinNodeId("Computer", "Fan1");
+    constexpr UA_UInt32 COMPUTER_FAN2 = builtinNodeId("Computer", "Fan2");
+    constexpr UA_UInt32 COMPUTER_FAN3 = builtinNodeId("Computer", "Fan3");
+    constexpr UA_UInt32 COMPUTER_CPU = builtinNodeId("Computer", "CPULoad");
+    constexpr UA_UInt32 COMPUTER_GPU = builtinNodeId("Computer", "GPULoad");
+    constexpr UA_UInt32 COMPUTER_RAM = builtinNodeId("Computer", "RAMUsage");
+
+    static_assert(MULTIMETER_VOLTAGE && MULTIMETER_CURRENT && MULTIMETER_RESISTANCE && MULTIMETER_POWER &&
+                  MACHINE_RPM && MACHINE_POWER && MACHINE_VOLTAGE && MACHINE_ENERGY &&
+                  MACHINE_TARGET_RPM && MACHINE_CONTROL_MODE &&
+                  COMPUTER_FAN1 && COMPUTER_FAN2 && COMPUTER_FAN3 && COMPUTER_CPU && COMPUTER_GPU && COMPUTER_RAM,
+                  "simulated tag missing from BUILTIN_TAGS");
+
+    const UA_UInt32 LOAD_FOLDER_ID = 9000;
+    const UA_UInt32 LOAD_TAG_BASE = 100000;
+    const UA_UInt32 DEVICE_TREE_BASE = 10000000;
+    const size_t DEVICE_TREE_STRIDE = 1000;
+
+    const size_t DEVICE_TAG_COUNT = BUILTIN_TAG_COUNT;
+    const double TWO_PI = 6.283185307179586;
+}
+
+
+
+SimServer::SimServer(const SimServerConfig& config)
+    : config(config)
+    , server(nullptr)
+    , callbackId(0)
+    , machineRPM(0.0)
+    , energyConsumption(0.0) {}
+
+SimServer::~SimServer() {
+    stop();
+}
+
+UA_NodeId SimServer::loadTagNodeId(size_t index) {
+    return UA_NODEID_NUMERIC(SIM_NS, LOAD_TAG_BASE + static_cast<UA_UInt32>(index));
+}
+
+std::string SimServer::getEndpoint() const {
+    return "opc.tcp://127.0.0.1:" + std::to_string(config.port);
+}
+
+size_t SimServer::getTagCount() const {
+    return DEVICE_TAG_COUNT + config.loadTags + config.devices * config.tagsPerDevice;
+}
+
+bool SimServer::start() {
+    if (running) return true;
+
+    server = UA_Server_new();
+    if (!server) return false;
+
+    if (UA_ServerConfig_setMinimal(UA_Server_getConfig(server), config.port, nullptr) != UA_STATUSCODE_GOOD ||
+        !populate()) {
+        std::cerr << "Failed to configure simulation server" << std::endl;
+        UA_Server_delete(server);
+        server = nullptr;
+        return false;
+    }
+
+    startTime = std::chrono::steady_clock::now();
+    lastUpdate = startTime;
+    machineRPM = 0.0;
+    energyConsumption = 0.0;
+    update();
+
+    UA_Server_addRepeatedCallback(server, updateCallback, this,
+                                  std::max(config.updateIntervalMs, 1.0), &callbackId);
+
+    if (UA_Server_run_startup(server) != UA_STATUSCODE_GOOD) {
+        std::cerr << "Failed to start simulation server on port " << config.port << std::endl;
+        UA_Server_delete(server);
+        server = nullptr;
+        return false;
+    }
+
+    running = true;
+    serverThread = std::thread(&SimServer::serverLoop, this);
+    return true;
+}
+
+void SimServer::stop() {
+    if (!server) return;
+
+    running = false;
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+
+    UA_Server_removeRepeatedCallback(server, callbackId);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    server = nullptr;
+}
+
+void SimServer::serverLoop() {
+    while (running) {
+        UA_Server_run_iterate(server, true);
+    }
+}
+
+bool SimServer::addObject(UA_UInt32 id, UA_UInt32 parentId, UA_UInt32 referenceType, const char* browseName) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), const_cast<char*>(browseName));
+
+    UA_NodeId parent = parentId == UA_NS0ID_OBJECTSFOLDER
+        ? UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER)
+        : UA_NODEID_NUMERIC(SIM_NS, parentId);
+
+    UA_StatusCode status = UA_Server_addObjectNode(
+        server, UA_NODEID_NUMERIC(SIM_NS, id), parent,
+        UA_NODEID_NUMERIC(0, referenceType),
+        UA_QUALIFIEDNAME(SIM_NS, const_cast<char*>(browseName)),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE), attr, nullptr, nullptr);
+
+    if (status != UA_STATUSCODE_GOOD) {
+        std::cerr << "Failed to add object " << browseName << ": " << UA_StatusCode_name(status) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SimServer::addVariable(UA_UInt32 id, UA_UInt32 parentId, const char* browseName,
+                            double initial, bool writable) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), const_cast<char*>(browseName));
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | (writable ? UA_ACCESSLEVELMASK_WRITE : 0);
+    UA_Variant_setScalar(&attr.value, &initial, &UA_TYPES[UA_TYPES_DOUBLE]);
+
+    UA_StatusCode status = UA_Server_addVariableNode(
+        server, UA_NODEID_NUMERIC(SIM_NS, id), UA_NODEID_NUMERIC(SIM_NS, parentId),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+        UA_QUALIFIEDNAME(SIM_NS, const_cast<char*>(browseName)),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), attr, nullptr, nullptr);
+
+    if (status != UA_STATUSCODE_GOOD) {
+        std::cerr << "Failed to add variable " << browseName << ": " << UA_StatusCode_name(status) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SimServer::populate() {
+    bool ok = true;
+    for (size_t d = 0; d < BUILTIN_DEVICE_COUNT && ok; d++) {
+        UA_UInt32 deviceId = builtinDeviceNodeId(d);
+        ok = addObject(deviceId, UA_NS0ID_OBJECTSFOLDER, UA_NS0ID_ORGANIZES,
+                       std::string(BUILTIN_DEVICES[d].name).c_str());
+
+        for (size_t t = 0; t < BUILTIN_TAG_COUNT && ok; t++) {
+            const BuiltinTag& tag = BUILTIN_TAGS[t];
+            if (tag.device != BUILTIN_DEVICES[d].name) continue;
+            double initial = t == BuiltinTags::MachineTargetRPM ? 1500.0 : 0.0;
+            ok = addVariable(builtinNodeId(t), deviceId, std::string(tag.name).c_str(), initial, tag.writable);
+        }
+    }
+
+    if (!ok) return false;
+
+    if (config.loadTags > 0) {
+        if (!addObject(LOAD_FOLDER_ID, UA_NS0ID_OBJECTSFOLDER, UA_NS0ID_ORGANIZES, "Load")) {
+            return false;
+        }
+
+        char name[32];
+        for (size_t i = 0; i < config.loadTags; i++) {
+            std::snprintf(name, sizeof(name), "Tag%06zu", i);
+            if (!addVariable(LOAD_TAG_BASE + static_cast<UA_UInt32>(i), LOAD_FOLDER_ID, name, 0.0, false)) {
+                return false;
+            }
+        }
+    }
+
+    size_t tagsPerDevice = std::min(config.tagsPerDevice, DEVICE_TREE_STRIDE - 1);
+    char name[32];
+    for (size_t d = 0; d < config.devices; d++) {
+        UA_UInt32 deviceId = DEVICE_TREE_BASE + static_cast<UA_UInt32>(d * DEVICE_TREE_STRIDE);
+        std::snprintf(name, sizeof(name), "Device%05zu", d);
+        if (!addObject(deviceId, UA_NS0ID_OBJECTSFOLDER, UA_NS0ID_ORGANIZES, name)) {
+            return false;
+        }
+        for (size_t t = 0; t < tagsPerDevice; t++) {
+            std::snprintf(name, sizeof(name), "Tag%03zu", t);
+            if (!addVariable(deviceId + 1 + static_cast<UA_UInt32>(t), deviceId, name, static_cast<double>(t), false)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void SimServer::setValue(UA_UInt32 id, double value) {
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Server_writeValue(server, UA_NODEID_NUMERIC(SIM_NS, id), v);
+}
+
+double SimServer::getValue(UA_UInt32 id) const {
+    UA_Variant v;
+    UA_Variant_init(&v);
+    double result = 0.0;
+    if (UA_Server_readValue(server, UA_NODEID_NUMERIC(SIM_NS, id), &v) == UA_STATUSCODE_GOOD &&
+        UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DOUBLE])) {
+        result = *static_cast<UA_Double*>(v.data);
+    }
+    UA_Variant_clear(&v);
+    return result;
+}
+
+void SimServer::updateCallback(UA_Server* server, void* context) {
+    static_cast<SimServer*>(context)->update();
+}
+
+void SimServer::update() {
+    auto now = std::chrono::steady_clock::now();
+    double t = std::chrono::duration<double>(now - startTime).count();
+    double dt = std::chrono::duration<double>(now - lastUpdate).count();
+    lastUpdate = now;
+
+    double voltage = 230.0 + 2.0 * std::sin(TWO_PI * t / 7.0);
+    double current = 5.0 + 0.5 * std::sin(TWO_PI * t / 3.0);
+    setValue(MULTIMETER_VOLTAGE, voltage);
+    setValue(MULTIMETER_CURRENT, current);
+    setValue(MULTIMETER_RESISTANCE, voltage / current);
+    setValue(MULTIMETER_POWER, voltage * current);
+
+    // Mode 0 runs a built-in speed profile, any other mode tracks TargetRPM.
+    double target = getValue(MACHINE_CONTROL_MODE) == 0.0
+        ? 1500.0 + 500.0 * std::sin(TWO_PI * t / 20.0)
+        : getValue(MACHINE_TARGET_RPM);
+    machineRPM += (target - machineRPM) * std::min(1.0, dt * 2.0);
+
+    double machinePower = 0.5 + machineRPM * 0.004;
+    energyConsumption += machinePower * dt / 3600.0;
+    setValue(MACHINE_RPM, machineRPM);
+    setValue(MACHINE_POWER, machinePower);
+    setValue(MACHINE_VOLTAGE, 380.0 + 3.0 * std::sin(TWO_PI * t / 11.0));
+    setValue(MACHINE_ENERGY, energyConsumption);
+
+    double cpuLoad = 35.0 + 25.0 * std::sin(TWO_PI * t / 13.0);
+    setValue(COMPUTER_FAN1, 900.0 + cpuLoad * 15.0);
+    setValue(COMPUTER_FAN2, 1000.0 + cpuLoad * 12.0);
+    setValue(COMPUTER_FAN3, 800.0 + 200.0 * std::sin(TWO_PI * t / 17.0));
+    setValue(COMPUTER_CPU, cpuLoad);
+    setValue(COMPUTER_GPU, 20.0 + 15.0 * std::sin(TWO_PI * t / 9.0));
+    setValue(COMPUTER_RAM, 55.0 + 5.0 * std::sin(TWO_PI * t / 30.0));
+
+    double wallClock = std::chrono::duration<double>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    for (size_t i = 0; i < config.loadTags; i++) {
+        double value = config.clockValues ? wallClock : 100.0 * std::sin(TWO_PI * t / 10.0 + i * 0.01);
+        setValue(LOAD_TAG_BASE + static_cast<UA_UInt32>(i), value);
+    }
+
+    updates.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#ifndef SIM_SERVER_H
+#define SIM_SERVER_H
+
+#include <open62541/server.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+
+struct SimServerConfig {
+    uint16_t port = 4840;
+    size_t loadTags = 0;
+    size_t devices = 0;
+    size_t tagsPerDevice = 10;
+    double updateIntervalMs = 100.0;
+    bool clockValues = false;
+};
+
+
+// Multimeter/Machine/Computer live under Objects exactly as the device
+// managers expect; loadTags extra doubles are placed under Objects/Load.
+// With clockValues the load tags carry the server wall clock in seconds,
+// so a client can measure sample age from the value alone. devices adds that
+// many static objects under Objects, each with tagsPerDevice doubles, for
+// exercising discovery.
+class SimServer {
+private:
+    SimServerConfig config;
+    UA_Server* server;
+    std::thread serverThread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> updates{0};
+    UA_UInt64 callbackId;
+
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastUpdate;
+    double machineRPM;
+    double energyConsumption;
+
+    bool populate();
+    bool addObject(UA_UInt32 id, UA_UInt32 parentId, UA_UInt32 referenceType, const char* browseName);
+    bool addVariable(UA_UInt32 id, UA_UInt32 parentId, const char* browseName, double initial, bool writable);
+    void setValue(UA_UInt32 id, double value);
+    double getValue(UA_UInt32 id) const;
+
+    void update();
+    void serverLoop();
+    static void updateCallback(UA_Server* server, void* context);
+
+public:
+    explicit SimServer(const SimServerConfig& config = SimServerConfig());
+    ~SimServer();
+
+    SimServer(const SimServer&) = delete;
+    SimServer& operator=(const SimServer&) = delete;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    std::string getEndpoint() const;
+    size_t getTagCount() const;
+    uint64_t getUpdateCount() const { return updates.load(std::memory_order_relaxed); }
+
+    static UA_NodeId loadTagNodeId(size_t index);
+};
+
+#endif
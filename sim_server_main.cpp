@@ -0,0 +1,65 @@
+#include "sim_server.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+    std::atomic<bool> g_running{true};
+
+    void signalHandler(int) {
+        g_running = false;
+    }
+}
+
+
+int main(int argc, char** argv) {
+    SimServerConfig config;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--port" && i + 1 < argc) {
+                config.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+            } else if (arg == "--tags" && i + 1 < argc) {
+                config.loadTags = std::stoul(argv[++i]);
+            } else if (arg == "--rate-ms" && i + 1 < argc) {
+                config.updateIntervalMs = std::stod(argv[++i]);
+            } else if (arg == "--devices" && i + 1 < argc) {
+                config.devices = std::stoul(argv[++i]);
+            } else if (arg == "--device-tags" && i + 1 < argc) {
+                config.tagsPerDevice = std::stoul(argv[++i]);
+            } else if (arg == "--clock-values") {
+                config.clockValues = true;
+            } else {
+                std::cerr << "Usage: KursovayaSimServer [--port N] [--tags N] [--rate-ms MS] [--devices N] [--device-tags N] [--clock-values]" << std::endl;
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    SimServer server(config);
+    if (!server.start()) {
+        return 1;
+    }
+
+    std::cout << "Simulation server at " << server.getEndpoint() << ", "
+              << server.getTagCount() << " tags, update every "
+              << config.updateIntervalMs << " ms" << std::endl;
+
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    server.stop();
+    std::cout << server.getUpdateCount() << " updates published" << std::endl;
+    return 0;
+}
@@ -90,37 +90,61 @@ SimpleWindow::SimpleWindow()
 }
 
 SimpleWindow::~SimpleWindow() {
+    if (connectThread.joinable()) connectThread.join();
+    if (pendingConnection) {
+        if (pendingConnection->pool) pendingConnection->pool->disconnect();
+        if (pendingConnection->client) pendingConnection->client->disconnect();
+    }
     if (asyncManager) asyncManager->stop();
+    if (recorder) recorder->stop();
+    if (pool) pool->disconnect();
     if (client) client->disconnect();
 }
 
+void SimpleWindow::setReplay(const std::string& directory, double speed, bool loop)
+{
+    replayDirectory = directory;
+    replaySpeed = speed;
+    replayLoop = loop;
+}
+
 bool SimpleWindow::initialize()
 {
     fontLoaded = font.openFromFile("res/fonts/DejaVuSans.ttf");
     return fontLoaded;
 }
 
+void SimpleWindow::setDeviceSchema(const DeviceSchema& schema)
+{
+    devices = DeviceRegistry(schema);
+    initializeAttributes();
+}
+
 void SimpleWindow::initializeAttributes()
 {
-    multimeterAttributes.clear();
-    multimeterAttributes.push_back(Attribute("voltage", "Напряжение", 0.0, false));
-    multimeterAttributes.push_back(Attribute("current", "Ток", 0.0, false));
-    multimeterAttributes.push_back(Attribute("resistance", "Сопротивление", 0.0, false));
-    multimeterAttributes.push_back(Attribute("power", "Мощность", 0.0, false));
-    
-    machineAttributes.clear();
-    machineAttributes.push_back(Attribute("rpm", "Обороты", 0.0, false));
-    machineAttributes.push_back(Attribute("power", "Мощность", 0.0, false));
-    machineAttributes.push_back(Attribute("voltage", "Напряжение", 0.0, false));
-    machineAttributes.push_back(Attribute("energy", "Энергопотребление", 0.0, false));
-    
-    computerAttributes.clear();
-    computerAttributes.push_back(Attribute("fan1", "Вентилятор 1", 0.0, false));
-    computerAttributes.push_back(Attribute("fan2", "Вентилятор 2", 0.0, false));
-    computerAttributes.push_back(Attribute("fan3", "Вентилятор 3", 0.0, false));
-    computerAttributes.push_back(Attribute("cpuLoad", "Загрузка CPU", 0.0, false));
-    computerAttributes.push_back(Attribute("gpuLoad", "Загрузка GPU", 0.0, false));
-    computerAttributes.push_back(Attribute("ramUsage", "Использование RAM", 0.0, false));
+    const TagTable& tags = devices.getTags();
+
+    deviceAttributes.clear();
+    for (const auto& device : devices.getDevices()) {
+        std::vector<Attribute> attributes;
+        for (size_t t = device.getFirstTag(); t < device.getEndTag(); ++t) {
+            if (tags.readable[t])
+                attributes.push_back(Attribute(tags.names[t], tags.displayNames[t], t));
+        }
+        deviceAttributes.push_back(std::move(attributes));
+    }
+
+    tagValues.assign(tags.size(), 0.0);
+    shownSequence = 0;
+}
+
+std::vector<SimpleWindow::Attribute>* SimpleWindow::attributesOf(const std::string& deviceName)
+{
+    for (const auto& device : devices.getDevices()) {
+        if (device.getDisplayName() == deviceName)
+            return &deviceAttributes[device.getIndex()];
+    }
+    return nullptr;
 }
 
 void SimpleWindow::run()
@@ -146,47 +170,20 @@ void SimpleWindow::handleEvents()
 
             auto mouse = sf::Mouse::getPosition(window);
 
-            if (!connected && isMouseOver(serverBox)) {
+            if (!connected && !connecting && isMouseOver(serverBox)) {
                 connectToServer();
                 return;
             }
 
-            if (connected && isMouseOver(disconnectBtn)) {
-                if (asyncManager) {
-                    asyncManager->stop();
-                    asyncManager.reset();
-                }
-
-                if (client) {
-                    client->disconnect();
-                    client.reset();
-                }
-
-                connected = false;
-                devicesInitialized = false;
-
-                rightPanelData.clear();
-                rightPanelSelection.clear();
-                expandedDevices.clear();
-
-                for (auto& a : multimeterAttributes) a.isSelected = false;
-                for (auto& a : machineAttributes) a.isSelected = false;
-                for (auto& a : computerAttributes) a.isSelected = false;
-
-                multimeterData = {};
-                machineData = {};
-                computerData = {};
-
+            if (connected && !connecting && isMouseOver(disconnectBtn)) {
+                disconnectFromServer();
                 return;
             }
 
             if (isMouseOver(moveRightBtn)) {
-                for (const auto& a : multimeterAttributes)
-                    if (a.isSelected) addAttributeToRightPanel("Мультиметр", a);
-                for (const auto& a : machineAttributes)
-                    if (a.isSelected) addAttributeToRightPanel("Станок", a);
-                for (const auto& a : computerAttributes)
-                    if (a.isSelected) addAttributeToRightPanel("Компьютер", a);
+                for (const auto& device : devices.getDevices())
+                    for (const auto& a : deviceAttributes[device.getIndex()])
+                        if (a.isSelected) addAttributeToRightPanel(device.getDisplayName(), a);
                 return;
             }
 
@@ -201,9 +198,8 @@ void SimpleWindow::handleEvents()
             if (isMouseOver(clearAllBtn)) {
                 rightPanelData.clear();
                 rightPanelSelection.clear();
-                for (auto& a : multimeterAttributes) a.isSelected = false;
-                for (auto& a : machineAttributes) a.isSelected = false;
-                for (auto& a : computerAttributes) a.isSelected = false;
+                for (auto& attributes : deviceAttributes)
+                    for (auto& a : attributes) a.isSelected = false;
                 return;
             }
 
@@ -214,7 +210,7 @@ void SimpleWindow::handleEvents()
                 float y = LEFT_PANEL_START_Y;
                 const float itemH = DEVICE_ITEM_HEIGHT;
 
-                auto toggleDevice = [&](DeviceType d) {
+                auto toggleDevice = [&](size_t d) {
                     auto it = std::find(expandedDevices.begin(), expandedDevices.end(), d);
                     if (it != expandedDevices.end())
                         expandedDevices.erase(it);
@@ -226,39 +222,17 @@ void SimpleWindow::handleEvents()
                     return mouse.y >= yy && mouse.y <= yy + itemH;
                 };
 
-                if (deviceHit(y)) toggleDevice(MULTIMETER);
-                bool mExp = std::find(expandedDevices.begin(), expandedDevices.end(), MULTIMETER) != expandedDevices.end();
-                y += itemH;
-
-                if (mExp) {
-                    for (auto& a : multimeterAttributes) {
-                        if (mouse.y >= y && mouse.y <= y + ATTR_LINE_HEIGHT)
-                            a.isSelected = !a.isSelected;
-                        y += ATTR_LINE_HEIGHT;
-                    }
-                }
-
-                if (deviceHit(y)) toggleDevice(MACHINE);
-                bool maExp = std::find(expandedDevices.begin(), expandedDevices.end(), MACHINE) != expandedDevices.end();
-                y += itemH;
-
-                if (maExp) {
-                    for (auto& a : machineAttributes) {
-                        if (mouse.y >= y && mouse.y <= y + ATTR_LINE_HEIGHT)
-                            a.isSelected = !a.isSelected;
-                        y += ATTR_LINE_HEIGHT;
-                    }
-                }
-
-                if (deviceHit(y)) toggleDevice(COMPUTER);
-                bool cExp = std::find(expandedDevices.begin(), expandedDevices.end(), COMPUTER) != expandedDevices.end();
-                y += itemH;
-
-                if (cExp) {
-                    for (auto& a : computerAttributes) {
-                        if (mouse.y >= y && mouse.y <= y + ATTR_LINE_HEIGHT)
-                            a.isSelected = !a.isSelected;
-                        y += ATTR_LINE_HEIGHT;
+                for (size_t d = 0; d < deviceAttributes.size(); ++d) {
+                    if (deviceHit(y)) toggleDevice(d);
+                    bool expanded = std::find(expandedDevices.begin(), expandedDevices.end(), d) != expandedDevices.end();
+                    y += itemH;
+
+                    if (expanded) {
+                        for (auto& a : deviceAttributes[d]) {
+                            if (mouse.y >= y && mouse.y <= y + ATTR_LINE_HEIGHT)
+                                a.isSelected = !a.isSelected;
+                            y += ATTR_LINE_HEIGHT;
+                        }
                     }
                 }
             }
@@ -290,8 +264,21 @@ void SimpleWindow::handleEvents()
 
 void SimpleWindow::update()
 {
+    std::unique_ptr<PendingConnection> ready;
+    {
+        std::lock_guard<std::mutex> lock(connectMutex);
+        ready = std::move(pendingConnection);
+    }
+    if (ready) finishConnect(*ready);
+
+    if (client) client->expireWrites();
     if (!connected || !asyncManager) return;
 
+    if (client && !replay && client->getNamespaceGeneration() != resolvedNamespaceGeneration) {
+        reresolveDevices();
+        return;
+    }
+
     static auto last = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
 
@@ -299,8 +286,8 @@ void SimpleWindow::update()
         return;
 
     last = now;
-    updateAttributes();
-    updateAttributeValues();
+    if (updateAttributes())
+        updateAttributeValues();
 }
 
 void SimpleWindow::render()
@@ -334,11 +321,27 @@ void SimpleWindow::drawHeader()
         22
     );
 
-    if (connected)
-        drawText("● opc.tcp://127.0.0.1:4840", 30.f, 18.f, sf::Color::White, 26);
+    if (connected && replay)
+        drawText("● Воспроизведение: " + replayDirectory, 30.f, 18.f, sf::Color::White, 26);
+    else if (connected && client && client->isReconnecting())
+        drawText("↻ Переподключение: " + endpoint, 30.f, 18.f, sf::Color::White, 26);
+    else if (connected)
+        drawText("● " + endpoint, 30.f, 18.f, sf::Color::White, 26);
+    else if (connecting)
+        drawText("… Подключение: " + endpoint, 30.f, 18.f, disabled, 26);
     else
         drawText("✖ Сервер не подключён", 30.f, 18.f, disabled, 26);
 
+    if (connected && asyncManager && asyncManager->getMode() == AcquisitionMode::PipelinedPolling) {
+        AsyncDataManager::PipelineStats stats = asyncManager->getPipelineStats();
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1)
+             << "Конвейер: выдано " << stats.issued << ", пропущено " << stats.dropped
+             << ", опоздало " << stats.late << ", ошибок " << stats.failed
+             << ", RTT " << stats.lastRttMs << " мс";
+        drawText(line.str(), 30.f, 50.f, disabled, 14);
+    }
+
     float padding = 15.f;
     float rightX = window.getSize().x - 120.f;
 
@@ -359,45 +362,21 @@ void SimpleWindow::drawLeftPanel()
     float y = LEFT_PANEL_START_Y;
     const float itemHeight = DEVICE_ITEM_HEIGHT;
     
-    bool isMultimeterExpanded = std::find(expandedDevices.begin(), expandedDevices.end(), MULTIMETER) != expandedDevices.end();
-    drawText(isMultimeterExpanded ? "▼ Мультиметр" : "▶ Мультиметр", 40.f, y, text, 22);
-    
-    if (isMultimeterExpanded) {
-        float attrY = y + itemHeight;
-        for (size_t i = 0; i < multimeterAttributes.size(); ++i) {
-            const auto& attr = multimeterAttributes[i];
-            sf::Color color = attr.isSelected ? selectedColor : text;
-            drawText("  • " + attr.displayName, 60.f, attrY, color, ATTR_FONT_SIZE);
-            attrY += ATTR_LINE_HEIGHT;
-        }
-    }
-    y += isMultimeterExpanded ? (multimeterAttributes.size() * ATTR_LINE_HEIGHT + itemHeight) : itemHeight;
-    
-    bool isMachineExpanded = std::find(expandedDevices.begin(), expandedDevices.end(), MACHINE) != expandedDevices.end();
-    drawText(isMachineExpanded ? "▼ Станок" : "▶ Станок", 40.f, y, text, 22);
-    
-    if (isMachineExpanded) {
-        float attrY = y + itemHeight;
-        for (size_t i = 0; i < machineAttributes.size(); ++i) {
-            const auto& attr = machineAttributes[i];
-            sf::Color color = attr.isSelected ? selectedColor : text;
-            drawText("  • " + attr.displayName, 60.f, attrY, color, ATTR_FONT_SIZE);
-            attrY += ATTR_LINE_HEIGHT;
-        }
-    }
-    y += isMachineExpanded ? (machineAttributes.size() * ATTR_LINE_HEIGHT + itemHeight) : itemHeight;
-    
-    bool isComputerExpanded = std::find(expandedDevices.begin(), expandedDevices.end(), COMPUTER) != expandedDevices.end();
-    drawText(isComputerExpanded ? "▼ Компьютер" : "▶ Компьютер", 40.f, y, text, 22);
-    
-    if (isComputerExpanded) {
-        float attrY = y + itemHeight;
-        for (size_t i = 0; i < computerAttributes.size(); ++i) {
-            const auto& attr = computerAttributes[i];
-            sf::Color color = attr.isSelected ? selectedColor : text;
-            drawText("  • " + attr.displayName, 60.f, attrY, color, ATTR_FONT_SIZE);
-            attrY += ATTR_LINE_HEIGHT;
+    for (const auto& device : devices.getDevices()) {
+        const auto& attributes = deviceAttributes[device.getIndex()];
+        bool isExpanded = std::find(expandedDevices.begin(), expandedDevices.end(), device.getIndex()) != expandedDevices.end();
+        drawText((isExpanded ? "▼ " : "▶ ") + device.getDisplayName(), 40.f, y, text, 22);
+
+        if (isExpanded) {
+            float attrY = y + itemHeight;
+            for (size_t i = 0; i < attributes.size(); ++i) {
+                const auto& attr = attributes[i];
+                sf::Color color = attr.isSelected ? selectedColor : text;
+                drawText("  • " + attr.displayName, 60.f, attrY, color, ATTR_FONT_SIZE);
+                attrY += ATTR_LINE_HEIGHT;
+            }
         }
+        y += isExpanded ? (attributes.size() * ATTR_LINE_HEIGHT + itemHeight) : itemHeight;
     }
 }
 
@@ -556,14 +535,12 @@ void SimpleWindow::addAttributeToRightPanel(const std::string& deviceName, const
     RightPanelAttribute rpAttr;
     rpAttr.name = attribute.name;
     rpAttr.displayName = attribute.displayName;
+    rpAttr.tag = attribute.tag;
     rpAttr.value = attribute.value;
 
     attrs.push_back(rpAttr);
 
-    std::vector<Attribute>* leftAttrs = nullptr;
-    if (deviceName == "Мультиметр") leftAttrs = &multimeterAttributes;
-    else if (deviceName == "Станок") leftAttrs = &machineAttributes;
-    else if (deviceName == "Компьютер") leftAttrs = &computerAttributes;
+    std::vector<Attribute>* leftAttrs = attributesOf(deviceName);
 
     if (leftAttrs) {
         for (auto& a : *leftAttrs)
@@ -593,10 +570,7 @@ void SimpleWindow::removeAttributeFromRightPanel(const std::string& fullName)
             rightPanelData.erase(deviceName);
     }
 
-    std::vector<Attribute>* leftAttrs = nullptr;
-    if (deviceName == "Мультиметр") leftAttrs = &multimeterAttributes;
-    else if (deviceName == "Станок") leftAttrs = &machineAttributes;
-    else if (deviceName == "Компьютер") leftAttrs = &computerAttributes;
+    std::vector<Attribute>* leftAttrs = attributesOf(deviceName);
 
     if (leftAttrs) {
         for (auto& a : *leftAttrs)
@@ -608,160 +582,235 @@ void SimpleWindow::removeAttributeFromRightPanel(const std::string& fullName)
 
 void SimpleWindow::updateAttributeValues()
 {
-    for (auto& attr : multimeterAttributes) {
-        if (attr.name == "voltage") attr.value = multimeterData.voltage;
-        else if (attr.name == "current") attr.value = multimeterData.current;
-        else if (attr.name == "resistance") attr.value = multimeterData.resistance;
-        else if (attr.name == "power") attr.value = multimeterData.power;
-    }
+    for (auto& attributes : deviceAttributes)
+        for (auto& attr : attributes)
+            attr.value = tagValues[attr.tag];
     
-    for (auto& attr : machineAttributes) {
-        if (attr.name == "rpm") attr.value = machineData.rpm;
-        else if (attr.name == "power") attr.value = machineData.power;
-        else if (attr.name == "voltage") attr.value = machineData.voltage;
-        else if (attr.name == "energy") attr.value = machineData.energy;
+    for (auto& [deviceName, attributes] : rightPanelData)
+        for (auto& attr : attributes)
+            attr.value = tagValues[attr.tag];
+}
+
+void SimpleWindow::disconnectFromServer()
+{
+    if (asyncManager) {
+        asyncManager->stop();
+        asyncManager.reset();
     }
-    
-    for (auto& attr : computerAttributes) {
-        if (attr.name == "fan1") attr.value = computerData.fan1;
-        else if (attr.name == "fan2") attr.value = computerData.fan2;
-        else if (attr.name == "fan3") attr.value = computerData.fan3;
-        else if (attr.name == "cpuLoad") attr.value = computerData.cpuLoad;
-        else if (attr.name == "gpuLoad") attr.value = computerData.gpuLoad;
-        else if (attr.name == "ramUsage") attr.value = computerData.ramUsage;
+
+    if (recorder) {
+        recorder->stop();
+        recorder.reset();
     }
-    
-    for (auto& [deviceName, attributes] : rightPanelData) {
-        for (auto& attr : attributes) {
-            if (deviceName == "Мультиметр") {
-                if (attr.name == "voltage") attr.value = multimeterData.voltage;
-                else if (attr.name == "current") attr.value = multimeterData.current;
-                else if (attr.name == "resistance") attr.value = multimeterData.resistance;
-                else if (attr.name == "power") attr.value = multimeterData.power;
-            }
-            else if (deviceName == "Станок") {
-                if (attr.name == "rpm") attr.value = machineData.rpm;
-                else if (attr.name == "power") attr.value = machineData.power;
-                else if (attr.name == "voltage") attr.value = machineData.voltage;
-                else if (attr.name == "energy") attr.value = machineData.energy;
-            }
-            else if (deviceName == "Компьютер") {
-                if (attr.name == "fan1") attr.value = computerData.fan1;
-                else if (attr.name == "fan2") attr.value = computerData.fan2;
-                else if (attr.name == "fan3") attr.value = computerData.fan3;
-                else if (attr.name == "cpuLoad") attr.value = computerData.cpuLoad;
-                else if (attr.name == "gpuLoad") attr.value = computerData.gpuLoad;
-                else if (attr.name == "ramUsage") attr.value = computerData.ramUsage;
-            }
-        }
+
+    replay.reset();
+
+    if (pool) {
+        pool->disconnect();
+        pool.reset();
+    }
+
+    if (client) {
+        client->disconnect();
+        client.reset();
     }
+
+    connected = false;
+    devicesInitialized = false;
+    devices.clearNodes();
+
+    rightPanelData.clear();
+    rightPanelSelection.clear();
+    expandedDevices.clear();
+
+    for (auto& attributes : deviceAttributes)
+        for (auto& a : attributes) a.isSelected = false;
+
+    std::fill(tagValues.begin(), tagValues.end(), 0.0);
+    shownSequence = 0;
 }
 
 void SimpleWindow::connectToServer()
 {
-    if (connected) return;
+    if (connected || connecting) return;
 
-    std::thread([this]() {
-        auto newClient = std::make_shared<OPCUAClient>("opc.tcp://127.0.0.1:4840");
-
-        if (!newClient->connect()) {
-            std::cerr << "Ошибка подключения к серверу OPC UA" << std::endl;
+    if (!replayDirectory.empty()) {
+        auto source = std::make_unique<ReplaySource>();
+        if (!source->load(replayDirectory)) {
+            std::cerr << "Не удалось загрузить запись из " << replayDirectory << std::endl;
             return;
         }
+        source->setSpeed(replaySpeed);
+        source->setLoop(replayLoop);
+
+        replay = std::move(source);
+        asyncManager = std::make_shared<AsyncDataManager>(replay.get(), &devices, 100);
+        asyncManager->start();
 
-        client = newClient;
         connected = true;
+        devicesInitialized = true;
+        return;
+    }
 
-        initializeDevices();
+    auto job = std::make_shared<PendingConnection>();
+    job->devices = devices;
+    launchConnect(job);
+}
 
-        if (!multimeter || !machine || !computer) {
-            std::cerr << "Устройства не инициализированы" << std::endl;
-            return;
+// The acquisition worker pumps the client, so it is stopped for the duration;
+// the session and pool are kept and only the nodes are looked up again.
+void SimpleWindow::reresolveDevices()
+{
+    asyncManager->stop();
+    asyncManager.reset();
+
+    std::cerr << "Пространства имён сервера изменились, повторный поиск устройств" << std::endl;
+
+    auto job = std::make_shared<PendingConnection>();
+    job->client = client;
+    job->pool = pool;
+    job->devices = devices;
+    job->reresolve = true;
+    launchConnect(job);
+}
+
+void SimpleWindow::launchConnect(std::shared_ptr<PendingConnection> job)
+{
+    if (connectThread.joinable()) connectThread.join();
+
+    connecting = true;
+    connectThread = std::thread([this, job]() {
+        auto result = std::make_unique<PendingConnection>(std::move(*job));
+
+        if (!result->client) {
+            auto newClient = std::make_shared<OPCUAClient>(endpoint);
+            if (newClient->connect()) {
+                newClient->enableAutoReconnect();
+                result->client = newClient;
+            } else {
+                std::cerr << "Ошибка подключения к серверу OPC UA" << std::endl;
+            }
         }
 
-        asyncManager = std::make_shared<AsyncDataManager>(
-            client.get(),
-            multimeter.get(),
-            machine.get(),
-            computer.get(),
-            100
-        );
+        if (result->client) {
+            result->namespaceGeneration = result->client->getNamespaceGeneration();
+            result->ok = resolveDevices(*result->client, result->devices);
+            if (!result->ok) {
+                std::cerr << "Устройства не инициализированы" << std::endl;
+            }
+            if (!result->ok && !result->reresolve) {
+                result->client->disconnect();
+                result->client.reset();
+            }
+        }
 
-        asyncManager->start();
+        if (result->ok && !result->pool && poolSize > 0) {
+            auto newPool = std::make_shared<OPCUAClientPool>(endpoint, poolSize);
+            if (newPool->connect()) {
+                newPool->start();
+                result->pool = newPool;
+            } else {
+                std::cerr << "Не удалось открыть пул сессий, чтение через основную сессию" << std::endl;
+            }
+        }
 
-    }).detach();
+        std::lock_guard<std::mutex> lock(connectMutex);
+        pendingConnection = std::move(result);
+    });
 }
 
-void SimpleWindow::initializeDevices()
+void SimpleWindow::finishConnect(PendingConnection& ready)
 {
-    if (!client || !client->isConnected())
+    if (connectThread.joinable()) connectThread.join();
+    connecting = false;
+    if (!ready.ok) {
+        if (ready.reresolve) disconnectFromServer();
         return;
+    }
+
+    client = std::move(ready.client);
+    pool = std::move(ready.pool);
+    devices = std::move(ready.devices);
+    resolvedNamespaceGeneration = ready.namespaceGeneration;
+
+    // A schema re-resolved in place keeps its rows, and with them the
+    // attribute lists and the right panel; discovery may renumber them.
+    if (!ready.reresolve || autoDiscover) {
+        rightPanelData.clear();
+        rightPanelSelection.clear();
+        initializeAttributes();
+    }
+
+    connected = true;
+    devicesInitialized = true;
+    startAcquisition();
+}
+
+void SimpleWindow::startAcquisition()
+{
+    bool pipelined = pipelineDepth > 0 && !pool;
+    asyncManager = std::make_shared<AsyncDataManager>(
+        client.get(),
+        &devices,
+        100,
+        pipelined ? AcquisitionMode::PipelinedPolling : AcquisitionMode::Polling
+    );
+    if (pipelined) {
+        asyncManager->setPipelineDepth(pipelineDepth);
+    }
+    if (pool) {
+        asyncManager->setClientPool(pool.get());
+    }
+
+    if (!recorder && !recordingDirectory.empty()) {
+        RecorderConfig recorderConfig;
+        recorderConfig.directory = recordingDirectory;
+        recorder = std::make_unique<Recorder>(recorderConfig);
+        if (recorder->start()) {
+            asyncManager->setRecorder(recorder.get());
+        } else {
+            std::cerr << "Не удалось запустить запись в " << recordingDirectory << std::endl;
+            recorder.reset();
+        }
+    } else if (recorder) {
+        asyncManager->setRecorder(recorder.get());
+    }
 
+    asyncManager->start();
+}
+
+bool SimpleWindow::resolveDevices(OPCUAClient& source, DeviceRegistry& registry) const
+{
     OPCUANode objectsNode(
         UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
         "Objects",
         "Objects Folder"
     );
 
-    multimeter = std::make_unique<MultimeterDevice>();
-    machine    = std::make_unique<MachineDevice>();
-    computer   = std::make_unique<ComputerDevice>();
-
-    bool m  = multimeter->initialize(*client, objectsNode);
-    bool ma = machine->initialize(*client, objectsNode);
-    bool c  = computer->initialize(*client, objectsNode);
-
-    devicesInitialized = m || ma || c;
+    return autoDiscover ? registry.discover(source, objectsNode) : registry.resolve(source, objectsNode);
 }
 
-void SimpleWindow::updateAttributes() {
+bool SimpleWindow::updateAttributes() {
     if (!connected || !asyncManager) {
-        multimeterData = {};
-        machineData = {};
-        computerData = {};
-        return;
+        std::fill(tagValues.begin(), tagValues.end(), 0.0);
+        shownSequence = 0;
+        return true;
     }
 
-    DeviceData data = asyncManager->getCurrentData();
+    auto data = asyncManager->getCurrentData();
+    if (data->sequence == shownSequence) return false;
 
-    if (data.multimeter.valid) {
-        updateMultimeterData(data.multimeter);
-    } else {
-        multimeterData = {};
-    }
+    auto refresh = [&](size_t t) {
+        if (t < tagValues.size() && t < data->values.size())
+            tagValues[t] = data->isUsable(t) ? data->values[t] : 0.0;
+    };
 
-    if (data.machine.valid) {
-        updateMachineData(data.machine);
+    if (data->sequence == shownSequence + 1) {
+        data->forEachDirty(refresh);
     } else {
-        machineData = {};
+        for (size_t t = 0; t < tagValues.size(); ++t) refresh(t);
     }
 
-    if (data.computer.valid) {
-        updateComputerData(data.computer);
-    } else {
-        computerData = {};
-    }
-}
-
-void SimpleWindow::updateMultimeterData(const DeviceData::MultimeterData& data) {
-    multimeterData.voltage    = data.voltage;
-    multimeterData.current    = data.current;
-    multimeterData.resistance = data.resistance;
-    multimeterData.power      = data.power;
+    shownSequence = data->sequence;
+    return true;
 }
-
-void SimpleWindow::updateMachineData(const DeviceData::MachineData& data) {
-    machineData.rpm     = data.rpm;
-    machineData.power   = data.power;
-    machineData.voltage = data.voltage;
-    machineData.energy  = data.energy;
-}
-
-void SimpleWindow::updateComputerData(const DeviceData::ComputerData& data) {
-    computerData.fan1     = data.fan1;
-    computerData.fan2     = data.fan2;
-    computerData.fan3     = data.fan3;
-    computerData.cpuLoad  = data.cpuLoad;
-    computerData.gpuLoad  = data.gpuLoad;
-    computerData.ramUsage = data.ramUsage;
-}
\ No newline at end of file
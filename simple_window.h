@@ -9,10 +9,14 @@
 #include <chrono>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <algorithm>
 #include "opcua_client.h"
 #include "device_managers.h"
 #include "async_manager.h"
+#include "recorder.h"
+#include "replay_source.h"
 
 
 class SimpleWindow {
@@ -22,22 +26,31 @@ public:
 
     bool initialize();
     void run();
+    void setRecordingDirectory(const std::string& directory) { recordingDirectory = directory; }
+    void setReplay(const std::string& directory, double speed, bool loop = false);
+    void setPipelineDepth(size_t depth) { pipelineDepth = depth; }
+    void setPoolSize(size_t sessions) { poolSize = sessions; }
+    void setEndpoint(const std::string& url) { endpoint = url; }
+    void setDeviceSchema(const DeviceSchema& schema);
+    void setAutoDiscover(bool enabled) { autoDiscover = enabled; }
 
 private:
     struct RightPanelAttribute {
         std::string name;
         std::string displayName;
+        size_t tag;
         double value;
     };
 
     struct Attribute {
         std::string name;
         std::string displayName;
+        size_t tag;
         double value;
         bool isSelected;
         
-        Attribute(const std::string& n, const std::string& dn, double v, bool sel = false)
-            : name(n), displayName(dn), value(v), isSelected(sel) {}
+        Attribute(const std::string& n, const std::string& dn, size_t t, double v = 0.0, bool sel = false)
+            : name(n), displayName(dn), tag(t), value(v), isSelected(sel) {}
     };
 
     struct RightPanelDevice {
@@ -45,38 +58,34 @@ private:
         std::vector<Attribute> attributes;
     };
 
-    enum DeviceType { 
-        NONE = 0, 
-        MULTIMETER = 1, 
-        MACHINE = 2, 
-        COMPUTER = 3 
-    };
-
-    void updateMultimeterData(const DeviceData::MultimeterData& data);
-    void updateMachineData(const DeviceData::MachineData& data);
-    void updateComputerData(const DeviceData::ComputerData& data);
-    
     sf::RenderWindow window;
     sf::Font font;
     bool fontLoaded{false};
     bool running{true};
 
     std::shared_ptr<OPCUAClient> client;
+    std::shared_ptr<OPCUAClientPool> pool;
     std::shared_ptr<AsyncDataManager> asyncManager;
-    std::unique_ptr<MultimeterDevice> multimeter;
-    std::unique_ptr<MachineDevice> machine;
-    std::unique_ptr<ComputerDevice> computer;
+    std::unique_ptr<Recorder> recorder;
+    std::string recordingDirectory;
+    std::string endpoint{"opc.tcp://127.0.0.1:4840"};
+    std::unique_ptr<ReplaySource> replay;
+    std::string replayDirectory;
+    double replaySpeed{1.0};
+    bool replayLoop{false};
+    size_t pipelineDepth{0};
+    size_t poolSize{0};
+    DeviceRegistry devices;
 
     bool connected{false};
+    bool connecting{false};
     bool devicesInitialized{false};
+    bool autoDiscover{false};
 
-    DeviceType selectedDevice{NONE};
-    std::vector<DeviceType> expandedDevices;
+    std::vector<size_t> expandedDevices;
     std::vector<std::string> selectedAttributes;
     
-    std::vector<Attribute> multimeterAttributes;
-    std::vector<Attribute> machineAttributes;
-    std::vector<Attribute> computerAttributes;
+    std::vector<std::vector<Attribute>> deviceAttributes;
     
     std::map<std::string, std::vector<RightPanelAttribute>> rightPanelData;
     std::set<std::string> rightPanelSelection;
@@ -99,18 +108,24 @@ private:
     sf::RectangleShape clearAllBtn;
     sf::RectangleShape disconnectBtn;
 
-    struct {
-        double voltage{}, current{}, resistance{}, power{};
-    } multimeterData;
-
-    struct {
-        double rpm{}, power{}, voltage{}, energy{};
-    } machineData;
-
-    struct {
-        double fan1{}, fan2{}, fan3{};
-        double cpuLoad{}, gpuLoad{}, ramUsage{};
-    } computerData;
+    std::vector<double> tagValues;
+    uint64_t shownSequence{0};
+
+    // Filled by the connect thread on a copy of the registry and handed to
+    // the UI thread, which swaps it in; the UI's registry, attributes and
+    // values are only ever touched from update()/render().
+    struct PendingConnection {
+        std::shared_ptr<OPCUAClient> client;
+        std::shared_ptr<OPCUAClientPool> pool;
+        DeviceRegistry devices;
+        uint64_t namespaceGeneration{0};
+        bool reresolve{false};
+        bool ok{false};
+    };
+    std::mutex connectMutex;
+    std::unique_ptr<PendingConnection> pendingConnection;
+    std::thread connectThread;
+    uint64_t resolvedNamespaceGeneration{0};
 
 private:
     void handleEvents();
@@ -136,6 +151,7 @@ private:
     std::string currentDate() const;
     
     void initializeAttributes();
+    std::vector<Attribute>* attributesOf(const std::string& deviceName);
     
     void handleAttributeClick(const std::string& deviceName, int attributeIndex);
     
@@ -145,8 +161,13 @@ private:
     void updateAttributeValues();
 
     void connectToServer();
-    void initializeDevices();
-    void updateAttributes();
+    void disconnectFromServer();
+    void reresolveDevices();
+    void launchConnect(std::shared_ptr<PendingConnection> job);
+    void finishConnect(PendingConnection& ready);
+    void startAcquisition();
+    bool resolveDevices(OPCUAClient& source, DeviceRegistry& registry) const;
+    bool updateAttributes();
 };
 
 #endif
\ No newline at end of file
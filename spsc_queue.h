@@ -0,0 +1,80 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+template<typename T>
+class SpscQueue {
+private:
+    std::vector<T> buffer;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t cachedTail{0};
+
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t cachedHead{0};
+
+    static size_t roundUp(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    explicit SpscQueue(size_t requestedCapacity)
+        : buffer(roundUp(requestedCapacity)), mask(buffer.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+
+    bool tryPush(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == buffer.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == buffer.size()) return false;
+        }
+        buffer[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        item = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t popBatch(T* out, size_t maxCount) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return 0;
+        }
+        size_t count = cachedTail - h;
+        if (count > maxCount) count = maxCount;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = buffer[(h + i) & mask];
+        }
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t sizeApprox() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return buffer.size(); }
+};
+
+#endif
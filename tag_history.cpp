@@ -0,0 +1,230 @@
+#include "tag_history.h"
+#include <algorithm>
+
+
+
+TagHistory::TagHistory(size_t requestedCapacity) {
+    capacity = 1;
+    while (capacity < std::max<size_t>(requestedCapacity, 2)) {
+        capacity <<= 1;
+    }
+    mask = capacity - 1;
+
+    timestamps.reset(new std::atomic<int64_t>[capacity]);
+    values.reset(new std::atomic<double>[capacity]);
+    qualities.reset(new std::atomic<uint32_t>[capacity]);
+
+    for (size_t i = 0; i < capacity; i++) {
+        timestamps[i].store(0, std::memory_order_relaxed);
+        values[i].store(0.0, std::memory_order_relaxed);
+        qualities[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void TagHistory::append(int64_t timestampUs, double value, uint32_t quality) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    size_t slot = index & mask;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    timestamps[slot].store(timestampUs, std::memory_order_relaxed);
+    values[slot].store(value, std::memory_order_relaxed);
+    qualities[slot].store(quality, std::memory_order_relaxed);
+
+    head.store(index + 1, std::memory_order_release);
+}
+
+size_t TagHistory::copyValid(uint64_t first, uint64_t last, HistorySample* out) const {
+    for (uint64_t i = first; i < last; i++) {
+        size_t slot = i & mask;
+        HistorySample& s = out[i - first];
+        s.timestampUs = timestamps[slot].load(std::memory_order_relaxed);
+        s.value = values[slot].load(std::memory_order_relaxed);
+        s.quality = qualities[slot].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t headAfter = head.load(std::memory_order_relaxed);
+
+    uint64_t oldestIntact = headAfter >= capacity ? headAfter - capacity + 1 : 0;
+    if (oldestIntact <= first) {
+        return static_cast<size_t>(last - first);
+    }
+    if (oldestIntact >= last) {
+        return 0;
+    }
+
+    size_t dropped = static_cast<size_t>(oldestIntact - first);
+    size_t kept = static_cast<size_t>(last - oldestIntact);
+    std::copy(out + dropped, out + dropped + kept, out);
+    return kept;
+}
+
+size_t TagHistory::readLast(size_t count, HistorySample* out) const {
+    uint64_t last = head.load(std::memory_order_acquire);
+    uint64_t available = std::min<uint64_t>(last, capacity);
+    uint64_t n = std::min<uint64_t>(count, available);
+    return copyValid(last - n, last, out);
+}
+
+size_t TagHistory::readRange(int64_t fromUs, int64_t toUs, HistorySample* out, size_t maxCount) const {
+    if (maxCount == 0 || fromUs > toUs) return 0;
+
+    uint64_t last = head.load(std::memory_order_acquire);
+    uint64_t oldest = last > capacity ? last - capacity + 1 : 0;
+    if (oldest >= last) return 0;
+
+    auto timestampAt = [this](uint64_t i) {
+        return timestamps[i & mask].load(std::memory_order_relaxed);
+    };
+
+    uint64_t lo = oldest;
+    uint64_t hi = last;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (timestampAt(mid) < fromUs) lo = mid + 1;
+        else hi = mid;
+    }
+
+    uint64_t first = lo;
+    uint64_t end = first;
+    while (end < last && end - first < maxCount && timestampAt(end) <= toUs) {
+        end++;
+    }
+
+    return copyValid(first, end, out);
+}
+
+size_t TagHistory::size() const {
+    return static_cast<size_t>(std::min<uint64_t>(head.load(std::memory_order_acquire), capacity));
+}
+
+size_t TagHistory::memoryUsage() const {
+    return capacity * (sizeof(int64_t) + sizeof(double) + sizeof(uint32_t));
+}
+
+
+
+ArrayHistory::ArrayHistory(size_t capacity) : ring(std::max<size_t>(capacity, 1)) {}
+
+void ArrayHistory::append(int64_t timestampUs, VariantBuffer&& buffer, uint32_t quality) {
+    auto owned = std::make_shared<VariantBuffer>(std::move(buffer));
+    size_t added = owned->byteSize();
+
+    std::shared_ptr<const VariantBuffer> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ArraySnapshot& slot = ring[head % ring.size()];
+        if (slot.buffer) bytes -= slot.buffer->byteSize();
+        evicted = std::move(slot.buffer);
+        slot = {timestampUs, quality, std::move(owned)};
+        bytes += added;
+        head++;
+    }
+}
+
+size_t ArrayHistory::readLast(size_t count, ArraySnapshot* out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t available = static_cast<size_t>(std::min<uint64_t>(head, ring.size()));
+    size_t n = std::min(count, available);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ring[(head - n + i) % ring.size()];
+    }
+    return n;
+}
+
+ArraySnapshot ArrayHistory::latest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (head == 0) return {0, 0, nullptr};
+    return ring[(head - 1) % ring.size()];
+}
+
+size_t ArrayHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<size_t>(std::min<uint64_t>(head, ring.size()));
+}
+
+uint64_t ArrayHistory::totalAppended() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return head;
+}
+
+size_t ArrayHistory::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ring.size() * sizeof(ArraySnapshot) + bytes;
+}
+
+
+
+HistoryStore::HistoryStore(size_t defaultCapacity) : defaultCapacity(defaultCapacity) {}
+
+void HistoryStore::setDefaultCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    defaultCapacity = capacity;
+}
+
+void HistoryStore::setCapacity(const std::string& tag, size_t capacity) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    capacityOverrides[tag] = capacity;
+}
+
+TagHistory* HistoryStore::registerTag(const std::string& tag) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto it = histories.find(tag);
+    if (it != histories.end()) {
+        return it->second.get();
+    }
+
+    auto capIt = capacityOverrides.find(tag);
+    size_t capacity = capIt != capacityOverrides.end() ? capIt->second : defaultCapacity;
+
+    auto history = std::make_unique<TagHistory>(capacity);
+    TagHistory* result = history.get();
+    histories.emplace(tag, std::move(history));
+    tagOrder.push_back(tag);
+    return result;
+}
+
+const TagHistory* HistoryStore::find(const std::string& tag) const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = histories.find(tag);
+    return it != histories.end() ? it->second.get() : nullptr;
+}
+
+ArrayHistory* HistoryStore::registerArrayTag(const std::string& tag, size_t snapshots) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto it = arrayHistories.find(tag);
+    if (it != arrayHistories.end()) {
+        return it->second.get();
+    }
+
+    auto history = std::make_unique<ArrayHistory>(snapshots);
+    ArrayHistory* result = history.get();
+    arrayHistories.emplace(tag, std::move(history));
+    tagOrder.push_back(tag);
+    return result;
+}
+
+const ArrayHistory* HistoryStore::findArray(const std::string& tag) const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = arrayHistories.find(tag);
+    return it != arrayHistories.end() ? it->second.get() : nullptr;
+}
+
+std::vector<std::string> HistoryStore::tagNames() const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return tagOrder;
+}
+
+size_t HistoryStore::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (const auto& [name, history] : histories) {
+        total += history->memoryUsage();
+    }
+    for (const auto& [name, history] : arrayHistories) {
+        total += history->memoryUsage();
+    }
+    return total;
+}
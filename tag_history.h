@@ -0,0 +1,110 @@
+#ifndef TAG_HISTORY_H
+#define TAG_HISTORY_H
+
+#include "variant_decoder.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+struct HistorySample {
+    int64_t timestampUs;
+    double value;
+    uint32_t quality;
+};
+
+
+class TagHistory {
+private:
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<std::atomic<int64_t>[]> timestamps;
+    std::unique_ptr<std::atomic<double>[]> values;
+    std::unique_ptr<std::atomic<uint32_t>[]> qualities;
+    alignas(64) std::atomic<uint64_t> head{0};
+
+    size_t copyValid(uint64_t first, uint64_t last, HistorySample* out) const;
+
+public:
+    explicit TagHistory(size_t requestedCapacity);
+
+    TagHistory(const TagHistory&) = delete;
+    TagHistory& operator=(const TagHistory&) = delete;
+
+
+    void append(int64_t timestampUs, double value, uint32_t quality = 0);
+
+
+    size_t readLast(size_t count, HistorySample* out) const;
+    size_t readRange(int64_t fromUs, int64_t toUs, HistorySample* out, size_t maxCount) const;
+
+    size_t size() const;
+    size_t getCapacity() const { return capacity; }
+    uint64_t totalAppended() const { return head.load(std::memory_order_acquire); }
+    size_t memoryUsage() const;
+};
+
+
+struct ArraySnapshot {
+    int64_t timestampUs;
+    uint32_t quality;
+    std::shared_ptr<const VariantBuffer> buffer;
+};
+
+
+// Waveform-style history: each append takes ownership of the decoded
+// buffer, readers share it by reference count instead of copying elements.
+class ArrayHistory {
+private:
+    mutable std::mutex mutex;
+    std::vector<ArraySnapshot> ring;
+    uint64_t head{0};
+    size_t bytes{0};
+
+public:
+    explicit ArrayHistory(size_t capacity);
+
+    ArrayHistory(const ArrayHistory&) = delete;
+    ArrayHistory& operator=(const ArrayHistory&) = delete;
+
+    void append(int64_t timestampUs, VariantBuffer&& buffer, uint32_t quality = 0);
+
+    size_t readLast(size_t count, ArraySnapshot* out) const;
+    ArraySnapshot latest() const;
+
+    size_t size() const;
+    size_t getCapacity() const { return ring.size(); }
+    uint64_t totalAppended() const;
+    size_t memoryUsage() const;
+};
+
+
+class HistoryStore {
+private:
+    mutable std::mutex registryMutex;
+    size_t defaultCapacity;
+    std::unordered_map<std::string, size_t> capacityOverrides;
+    std::unordered_map<std::string, std::unique_ptr<TagHistory>> histories;
+    std::unordered_map<std::string, std::unique_ptr<ArrayHistory>> arrayHistories;
+    std::vector<std::string> tagOrder;
+
+public:
+    explicit HistoryStore(size_t defaultCapacity = 4096);
+
+    void setDefaultCapacity(size_t capacity);
+    void setCapacity(const std::string& tag, size_t capacity);
+
+    TagHistory* registerTag(const std::string& tag);
+    const TagHistory* find(const std::string& tag) const;
+
+    ArrayHistory* registerArrayTag(const std::string& tag, size_t snapshots);
+    const ArrayHistory* findArray(const std::string& tag) const;
+    std::vector<std::string> tagNames() const;
+    size_t memoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "tag_store.h"
+
+
+
+TagStore::Slot* TagStore::registerTag(uint32_t serverId, const std::string& tag) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+
+    auto key = std::make_pair(serverId, tag);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        return it->second;
+    }
+
+    Slot& slot = slots.emplace_back();
+    slot.serverId = serverId;
+    slot.tag = tag;
+    index.emplace(std::move(key), &slot);
+    return &slot;
+}
+
+bool TagStore::read(uint32_t serverId, const std::string& tag, TagValue& out) const {
+    const Slot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        auto it = index.find({serverId, tag});
+        if (it == index.end()) return false;
+        slot = it->second;
+    }
+
+    out = slot->value.load();
+    return true;
+}
+
+std::vector<std::pair<std::string, TagValue>> TagStore::snapshot(uint32_t serverId) const {
+    std::vector<std::pair<std::string, TagValue>> values;
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = index.lower_bound({serverId, std::string()});
+    for (; it != index.end() && it->first.first == serverId; ++it) {
+        values.emplace_back(it->first.second, it->second->value.load());
+    }
+    return values;
+}
+
+size_t TagStore::size() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return slots.size();
+}
@@ -0,0 +1,64 @@
+#ifndef TAG_STORE_H
+#define TAG_STORE_H
+
+#include "seqlock.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+struct TagValue {
+    double value;
+    int64_t timestampUs;
+    uint32_t quality;
+    bool valid;
+};
+
+
+// Latest value per (server, tag). Slots never move once registered, so
+// writers keep the pointer and publish without touching the index.
+class TagStore {
+public:
+    struct Slot {
+        SeqLock<TagValue> value;
+        uint32_t serverId{0};
+        std::string tag;
+
+        void publish(int64_t timestampUs, double v, uint32_t quality = 0) {
+            value.store({v, timestampUs, quality, true});
+        }
+
+        // Keeps the last value; quality and timestamp say why and since when
+        // it is no longer current.
+        void invalidate(int64_t timestampUs, uint32_t quality) {
+            TagValue current = value.load();
+            current.timestampUs = timestampUs;
+            current.quality = quality;
+            current.valid = false;
+            value.store(current);
+        }
+    };
+
+private:
+    mutable std::mutex indexMutex;
+    std::deque<Slot> slots;
+    std::map<std::pair<uint32_t, std::string>, Slot*> index;
+
+public:
+    TagStore() = default;
+
+    TagStore(const TagStore&) = delete;
+    TagStore& operator=(const TagStore&) = delete;
+
+    Slot* registerTag(uint32_t serverId, const std::string& tag);
+
+    bool read(uint32_t serverId, const std::string& tag, TagValue& out) const;
+    std::vector<std::pair<std::string, TagValue>> snapshot(uint32_t serverId) const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef VARIANT_DECODER_H
+#define VARIANT_DECODER_H
+
+#include <open62541/types.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+
+template<typename T>
+using VariantDecoder = size_t (*)(const void* data, size_t count, T* out, size_t outSize);
+
+
+namespace variant_detail {
+    template<int Kind> struct KindType;
+    template<> struct KindType<UA_DATATYPEKIND_BOOLEAN> { using type = UA_Boolean; };
+    template<> struct KindType<UA_DATATYPEKIND_SBYTE> { using type = UA_SByte; };
+    template<> struct KindType<UA_DATATYPEKIND_BYTE> { using type = UA_Byte; };
+    template<> struct KindType<UA_DATATYPEKIND_INT16> { using type = UA_Int16; };
+    template<> struct KindType<UA_DATATYPEKIND_UINT16> { using type = UA_UInt16; };
+    template<> struct KindType<UA_DATATYPEKIND_INT32> { using type = UA_Int32; };
+    template<> struct KindType<UA_DATATYPEKIND_UINT32> { using type = UA_UInt32; };
+    template<> struct KindType<UA_DATATYPEKIND_INT64> { using type = UA_Int64; };
+    template<> struct KindType<UA_DATATYPEKIND_UINT64> { using type = UA_UInt64; };
+    template<> struct KindType<UA_DATATYPEKIND_FLOAT> { using type = UA_Float; };
+    template<> struct KindType<UA_DATATYPEKIND_DOUBLE> { using type = UA_Double; };
+
+    constexpr size_t NumericKinds = UA_DATATYPEKIND_DOUBLE + 1;
+
+    template<typename From, typename To>
+    size_t convert(const void* data, size_t count, To* out, size_t outSize) {
+        size_t n = count < outSize ? count : outSize;
+        if constexpr (std::is_same_v<From, To>) {
+            std::memcpy(out, data, n * sizeof(To));
+        } else {
+            const From* in = static_cast<const From*>(data);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = static_cast<To>(in[i]);
+            }
+        }
+        return n;
+    }
+
+    template<typename To, size_t... Kinds>
+    constexpr std::array<VariantDecoder<To>, sizeof...(Kinds)> makeTable(std::index_sequence<Kinds...>) {
+        return {{&convert<typename KindType<static_cast<int>(Kinds)>::type, To>...}};
+    }
+
+    template<typename T> struct TypeIndex;
+    template<> struct TypeIndex<bool> { static constexpr int value = UA_TYPES_BOOLEAN; };
+    template<> struct TypeIndex<int8_t> { static constexpr int value = UA_TYPES_SBYTE; };
+    template<> struct TypeIndex<uint8_t> { static constexpr int value = UA_TYPES_BYTE; };
+    template<> struct TypeIndex<int16_t> { static constexpr int value = UA_TYPES_INT16; };
+    template<> struct TypeIndex<uint16_t> { static constexpr int value = UA_TYPES_UINT16; };
+    template<> struct TypeIndex<int32_t> { static constexpr int value = UA_TYPES_INT32; };
+    template<> struct TypeIndex<uint32_t> { static constexpr int value = UA_TYPES_UINT32; };
+    template<> struct TypeIndex<int64_t> { static constexpr int value = UA_TYPES_INT64; };
+    template<> struct TypeIndex<uint64_t> { static constexpr int value = UA_TYPES_UINT64; };
+    template<> struct TypeIndex<float> { static constexpr int value = UA_TYPES_FLOAT; };
+    template<> struct TypeIndex<double> { static constexpr int value = UA_TYPES_DOUBLE; };
+}
+
+
+// Enumerations travel as Int32 on the wire; everything else that is not a
+// numeric built-in has no decoder.
+template<typename T>
+VariantDecoder<T> resolveDecoder(const UA_DataType* type) {
+    static constexpr auto table = variant_detail::makeTable<T>(
+        std::make_index_sequence<variant_detail::NumericKinds>{});
+
+    if (!type) return nullptr;
+    if (type->typeKind == UA_DATATYPEKIND_ENUM) return table[UA_DATATYPEKIND_INT32];
+    if (type->typeKind >= variant_detail::NumericKinds) return nullptr;
+    return table[type->typeKind];
+}
+
+template<typename T>
+const UA_DataType* uaDataTypeOf() {
+    return &UA_TYPES[variant_detail::TypeIndex<T>::value];
+}
+
+template<typename T>
+size_t decodeVariant(const UA_Variant& v, T* out, size_t outSize) {
+    VariantDecoder<T> fn = resolveDecoder<T>(v.type);
+    if (!fn || !v.data) return 0;
+    return fn(v.data, UA_Variant_isScalar(&v) ? 1 : v.arrayLength, out, outSize);
+}
+
+template<typename T>
+bool decodeScalar(const UA_Variant& v, T& out) {
+    VariantDecoder<T> fn = resolveDecoder<T>(v.type);
+    return fn && UA_Variant_isScalar(&v) && fn(v.data, 1, &out, 1) == 1;
+}
+
+
+namespace variant_detail {
+    template<typename T>
+    bool encodeAs(double value, const UA_DataType* type, UA_Variant& out) {
+        T v = static_cast<T>(value);
+        return UA_Variant_setScalarCopy(&out, &v, type) == UA_STATUSCODE_GOOD;
+    }
+}
+
+// Setpoints are handled as double and narrowed to the node's declared type
+// on the way out.
+inline bool encodeScalar(double value, const UA_DataType* type, UA_Variant& out) {
+    if (!type) return false;
+    switch (type->typeKind) {
+        case UA_DATATYPEKIND_BOOLEAN: return variant_detail::encodeAs<UA_Boolean>(value, type, out);
+        case UA_DATATYPEKIND_SBYTE: return variant_detail::encodeAs<UA_SByte>(value, type, out);
+        case UA_DATATYPEKIND_BYTE: return variant_detail::encodeAs<UA_Byte>(value, type, out);
+        case UA_DATATYPEKIND_INT16: return variant_detail::encodeAs<UA_Int16>(value, type, out);
+        case UA_DATATYPEKIND_UINT16: return variant_detail::encodeAs<UA_UInt16>(value, type, out);
+        case UA_DATATYPEKIND_ENUM:
+        case UA_DATATYPEKIND_INT32: return variant_detail::encodeAs<UA_Int32>(value, type, out);
+        case UA_DATATYPEKIND_UINT32: return variant_detail::encodeAs<UA_UInt32>(value, type, out);
+        case UA_DATATYPEKIND_INT64: return variant_detail::encodeAs<UA_Int64>(value, type, out);
+        case UA_DATATYPEKIND_UINT64: return variant_detail::encodeAs<UA_UInt64>(value, type, out);
+        case UA_DATATYPEKIND_FLOAT: return variant_detail::encodeAs<UA_Float>(value, type, out);
+        case UA_DATATYPEKIND_DOUBLE: return variant_detail::encodeAs<UA_Double>(value, type, out);
+        default: return false;
+    }
+}
+
+
+// Remembers the decoder for the last type seen on one node, so steady-state
+// reads cost a pointer compare and an indirect call.
+template<typename T>
+struct CachedDecoder {
+    const UA_DataType* type{nullptr};
+    VariantDecoder<T> fn{nullptr};
+
+    bool decodeScalar(const UA_Variant& v, T& out) {
+        if (v.type != type) {
+            type = v.type;
+            fn = resolveDecoder<T>(type);
+        }
+        return fn && UA_Variant_isScalar(&v) && fn(v.data, 1, &out, 1) == 1;
+    }
+
+    size_t decode(const UA_Variant& v, T* out, size_t outSize) {
+        if (v.type != type) {
+            type = v.type;
+            fn = resolveDecoder<T>(type);
+        }
+        if (!fn || !v.data) return 0;
+        return fn(v.data, UA_Variant_isScalar(&v) ? 1 : v.arrayLength, out, outSize);
+    }
+};
+
+
+template<typename T>
+struct ArrayView {
+    const T* data{nullptr};
+    size_t size{0};
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+
+// Owns a decoded UA_Variant taken out of a service response, so array
+// payloads are handed on without copying the element buffer.
+class VariantBuffer {
+private:
+    UA_Variant variant;
+
+public:
+    VariantBuffer() { UA_Variant_init(&variant); }
+    ~VariantBuffer() { UA_Variant_clear(&variant); }
+
+    VariantBuffer(const VariantBuffer&) = delete;
+    VariantBuffer& operator=(const VariantBuffer&) = delete;
+
+    VariantBuffer(VariantBuffer&& other) noexcept : variant(other.variant) {
+        UA_Variant_init(&other.variant);
+    }
+
+    VariantBuffer& operator=(VariantBuffer&& other) noexcept {
+        if (this != &other) {
+            UA_Variant_clear(&variant);
+            variant = other.variant;
+            UA_Variant_init(&other.variant);
+        }
+        return *this;
+    }
+
+    void adopt(UA_Variant& source) {
+        UA_Variant_clear(&variant);
+        variant = source;
+        UA_Variant_init(&source);
+    }
+
+    void reset() { UA_Variant_clear(&variant); }
+
+    const UA_Variant& get() const { return variant; }
+    const UA_DataType* type() const { return variant.type; }
+    bool empty() const { return size() == 0; }
+    bool isArray() const { return variant.type && !UA_Variant_isScalar(&variant); }
+
+    size_t size() const {
+        if (!variant.type || variant.data <= UA_EMPTY_ARRAY_SENTINEL) return 0;
+        return UA_Variant_isScalar(&variant) ? 1 : variant.arrayLength;
+    }
+
+    size_t byteSize() const { return variant.type ? size() * variant.type->memSize : 0; }
+
+    template<typename T>
+    ArrayView<T> view() const {
+        if (variant.type != uaDataTypeOf<T>() || empty()) return {};
+        return {static_cast<const T*>(variant.data), size()};
+    }
+
+    template<typename T>
+    size_t decode(T* out, size_t outSize) const {
+        return empty() ? 0 : decodeVariant(variant, out, outSize);
+    }
+};
+
+#endif